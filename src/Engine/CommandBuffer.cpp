@@ -0,0 +1,111 @@
+#include "CommandBuffer.hpp"
+
+CommandBuffer::CommandBuffer() :
+m_id(s_nextId++)
+{
+}
+
+CommandEntity CommandBuffer::CreateEntity()
+{
+	CommandEntity entity;
+	entity.value = m_placeholderCount++;
+	entity.placeholder = true;
+	entity.buffer = m_id;
+	entity.generation = m_generation;
+
+	Record(CommandType::CREATE, entity, 0, nullptr);
+
+	return entity;
+}
+
+void CommandBuffer::DestroyEntity(const CommandEntity entity)
+{
+	Record(CommandType::DESTROY, entity, 0, nullptr);
+}
+
+bool CommandBuffer::Empty() const
+{
+	return m_commands.empty();
+}
+
+void CommandBuffer::Playback(Registry& registry)
+{
+	std::vector<Command> commands;
+
+	// Callbacks fired during playback may record new commands into this buffer
+	while (!m_commands.empty())
+	{
+		std::swap(commands, m_commands);
+		m_resolved.resize(m_placeholderCount, NULL_ENTITY);
+
+		for (const Command& command : commands)
+		{
+			if (command.type == CommandType::CREATE)
+			{
+				m_resolved[command.entity] = registry.CreateEntity();
+				continue;
+			}
+
+			const Entity entity = command.placeholder ? m_resolved[command.entity] : static_cast<Entity>(command.entity);
+
+			switch (command.type)
+			{
+			case CommandType::CREATE:
+			{
+			}
+			break;
+
+			case CommandType::DESTROY:
+			{
+				registry.DestroyEntity(entity);
+			}
+			break;
+
+			case CommandType::EMPLACE:
+			case CommandType::REMOVE:
+			{
+				command.apply(*this, registry, entity, command.payload);
+			}
+			break;
+			}
+		}
+
+		commands.clear();
+	}
+
+	Clear();
+}
+
+void CommandBuffer::Clear()
+{
+	m_commands.clear();
+
+	for (auto& payload : m_payloads)
+	{
+		if (payload)
+		{
+			payload->Clear();
+		}
+	}
+
+	m_placeholderCount = 0;
+	m_resolved.clear();
+
+	m_generation++;
+}
+
+void CommandBuffer::Record(const CommandType type, const CommandEntity entity, const u64 payload,
+const ApplyFunction apply)
+{
+	if (entity.placeholder)
+	{
+		Assert(entity.buffer == m_id, "Placeholder belongs to another command buffer");
+		Assert(entity.generation == m_generation, "Placeholder was already played back or cleared");
+	}
+
+	m_commands.push_back(Command{.type = type,
+	.placeholder = entity.placeholder,
+	.entity = entity.value,
+	.payload = static_cast<u32>(payload),
+	.apply = apply});
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "Assert.hpp"
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include "Engine/Registry.hpp"
+#include "entt/entt.hpp"
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @file CommandBuffer.hpp
+ * @brief Deferred structural registry changes.
+ */
+
+/**
+ * @brief Entity reference usable inside a CommandBuffer
+ *
+ * Either refers to an existing entity or to a placeholder returned by
+ * CommandBuffer::CreateEntity, which is resolved to a real entity on playback.
+ * A placeholder is only valid in the buffer that created it until that buffer
+ * is played back or cleared. Implicitly constructible from an Entity.
+ */
+struct CommandEntity
+{
+	CommandEntity() = default;
+
+	CommandEntity(const Entity entity) : // NOLINT
+	value(static_cast<u32>(entity))
+	{
+	}
+
+	u32 value = 0;
+	bool placeholder = false;
+
+	// Buffer and playback generation a placeholder was created in, checked when it is used
+	u32 buffer = 0;
+	u32 generation = 0;
+};
+
+/**
+ * @brief Records structural registry changes to be applied later
+ *
+ * Creating and destroying entities or adding and removing components while a view
+ * is being iterated, or from a thread pool task, is not safe. Instead these changes
+ * are recorded into a CommandBuffer and applied at a defined sync point by Playback.
+ *
+ * Commands are stored as small POD records; component payloads are kept in
+ * contiguous per-type arrays. Commands are applied in the order they were recorded.
+ *
+ * A buffer must only be recorded into by one thread at a time. Use
+ * Registry::GetCommandBuffer to get the calling thread's own buffer, which the
+ * Engine plays back after the systems and at the end of every fixed update step.
+ *
+ * Usage:
+ * @code
+ * CommandBuffer& commands = REGISTRY.GetCommandBuffer();
+ *
+ * CommandEntity bullet = commands.CreateEntity();
+ * commands.Emplace<Component::Transform>(bullet, position, velocity);
+ * commands.DestroyEntity(entity);
+ * @endcode
+ */
+class CommandBuffer : public NonCopyable<>
+{
+public:
+
+	/**
+	 * @brief Creates an empty buffer
+	 */
+	CommandBuffer();
+
+	/**
+	 * @brief Records the creation of a new entity
+	 *
+	 * @return Placeholder that can be used with the other commands of this buffer
+	 */
+	CommandEntity CreateEntity();
+
+	/**
+	 * @brief Records the destruction of an entity
+	 *
+	 * Does nothing on playback if the entity is no longer valid.
+	 *
+	 * @param entity Entity or placeholder to destroy
+	 */
+	void DestroyEntity(const CommandEntity entity);
+
+	/**
+	 * @brief Records adding a component to an entity
+	 *
+	 * The component is constructed immediately and moved into the registry on playback.
+	 * Follows Registry::Emplace, so nothing happens if the entity already has the
+	 * component. Does nothing on playback if the entity is no longer valid.
+	 *
+	 * @tparam Component Component type to add
+	 * @tparam Args Component constructor argument types
+	 * @param entity Entity or placeholder receiving the component
+	 * @param args Component constructor arguments
+	 */
+	template <typename Component, typename... Args>
+	void Emplace(const CommandEntity entity, Args&&... args)
+	{
+		PayloadPool<Component>& pool = GetPayloadPool<Component>();
+
+		if constexpr (std::is_aggregate_v<Component>)
+		{
+			pool.values.push_back(Component{std::forward<Args>(args)...});
+		}
+
+		else
+		{
+			pool.values.emplace_back(std::forward<Args>(args)...);
+		}
+
+		Record(CommandType::EMPLACE, entity, pool.values.size() - 1, &CommandBuffer::ApplyEmplace<Component>);
+	}
+
+	/**
+	 * @brief Records removing a component from an entity
+	 *
+	 * Does nothing on playback if the entity is no longer valid or lacks the component.
+	 *
+	 * @tparam Component Component type to remove
+	 * @param entity Entity or placeholder losing the component
+	 */
+	template <typename Component>
+	void Remove(const CommandEntity entity)
+	{
+		Record(CommandType::REMOVE, entity, 0, &CommandBuffer::ApplyRemove<Component>);
+	}
+
+	/**
+	 * @brief Checks whether any commands are waiting for playback
+	 *
+	 * @return True if no commands are recorded
+	 */
+	bool Empty() const;
+
+	/**
+	 * @brief Applies all recorded commands to a registry and clears the buffer
+	 *
+	 * Placeholders are resolved to newly created entities in recording order.
+	 * Commands recorded by callbacks during playback are applied as well.
+	 * Must not run while another thread records into this buffer.
+	 *
+	 * @param registry Registry to apply the commands to
+	 */
+	void Playback(Registry& registry);
+
+	/**
+	 * @brief Discards all recorded commands
+	 *
+	 * Placeholders created so far become invalid.
+	 */
+	void Clear();
+
+private:
+
+	enum class CommandType : u8
+	{
+		CREATE,
+		DESTROY,
+		EMPLACE,
+		REMOVE
+	};
+
+	using ApplyFunction = void (*)(CommandBuffer& buffer, Registry& registry, const Entity entity, const u32 payload);
+
+	struct Command
+	{
+		CommandType type = CommandType::CREATE;
+		bool placeholder = false;
+		u32 entity = 0;
+		u32 payload = 0;
+		ApplyFunction apply = nullptr;
+	};
+
+	static_assert(std::is_trivially_copyable_v<Command>);
+
+	struct PayloadPoolBase
+	{
+		virtual ~PayloadPoolBase() = default;
+
+		virtual void Clear() = 0;
+	};
+
+	template <typename Component>
+	struct PayloadPool : PayloadPoolBase
+	{
+		std::vector<Component> values;
+
+		void Clear() override
+		{
+			values.clear();
+		}
+	};
+
+	template <typename Component>
+	PayloadPool<Component>& GetPayloadPool()
+	{
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= m_payloads.size())
+		{
+			m_payloads.resize(index + 1);
+		}
+
+		std::unique_ptr<PayloadPoolBase>& ptr = m_payloads[index];
+		if (!ptr)
+		{
+			ptr = std::make_unique<PayloadPool<Component>>();
+		}
+
+		return static_cast<PayloadPool<Component>&>(*ptr);
+	}
+
+	template <typename Component>
+	static void ApplyEmplace(CommandBuffer& buffer, Registry& registry, const Entity entity, const u32 payload)
+	{
+		auto& pool = static_cast<PayloadPool<Component>&>(*buffer.m_payloads[entt::type_index<Component>::value()]);
+
+		// Moved out first as callbacks may record further payloads and grow the pool
+		Component component = std::move(pool.values[payload]);
+
+		if (registry.EntityValid(entity))
+		{
+			registry.Emplace<Component>(entity, std::move(component));
+		}
+	}
+
+	template <typename Component>
+	static void ApplyRemove([[maybe_unused]] CommandBuffer& buffer, Registry& registry, const Entity entity,
+	[[maybe_unused]] const u32 payload)
+	{
+		if (registry.EntityValid(entity))
+		{
+			registry.Remove<Component>(entity);
+		}
+	}
+
+	void Record(const CommandType type, const CommandEntity entity, const u64 payload, const ApplyFunction apply);
+
+	std::vector<Command> m_commands;
+	std::vector<std::unique_ptr<PayloadPoolBase>> m_payloads;
+
+	u32 m_placeholderCount = 0;
+	std::vector<Entity> m_resolved;
+
+	static inline std::atomic<u32> s_nextId = 1;
+	u32 m_id = 0;
+
+	// Bumped by every Clear so placeholders kept past playback are caught
+	u32 m_generation = 0;
+};
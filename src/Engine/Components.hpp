@@ -36,6 +36,21 @@ namespace Component
 		constexpr bool operator<=>(const Transform&) const = default;
 	};
 
+	/**
+	 * @struct PreviousTransform
+	 * @brief Transform state at the start of the current fixed step.
+	 *
+	 * Opt in: entities having it are drawn between their previous and current
+	 * transform using the engine's interpolation alpha. The engine refreshes it
+	 * before every fixed step. Add it with Renderer::ResetInterpolation so it
+	 * starts out matching the transform.
+	 */
+	struct PreviousTransform
+	{
+		Vec2<float> position;
+		float rotation = 0;
+	};
+
 	/**
 	 * @struct Sprite
 	 * @brief Texture, source rectangle, tint, scale and render layer.
@@ -1,28 +1,50 @@
 #include "Engine.hpp"
 
 #include "Engine/Systems/NetworkEntitySystem.hpp"
+#include "Engine/Trace.hpp"
 #include "Systems/AnimationSystem.hpp"
 #include "Systems/ParticleSystem.hpp"
 
 #include "Timing.hpp"
+#include "rlgl.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
 
 Engine::Engine(const WindowInfo& windowInfo) :
-m_renderer(m_registry, windowInfo.virtualWidth, windowInfo.virtualHeight)
+m_renderer(m_registry, windowInfo.virtualWidth, windowInfo.virtualHeight),
+m_systemManager(m_registry)
 {
 	Assert(!s_engine, "Only one engine instance may exist at the time");
 
 	s_engine = this;
 
-	SetFlags(windowInfo);
+#ifndef __EMSCRIPTEN__
+	m_registry.SetThreadPool(&threadPool);
+	m_systemManager.SetThreadPool(&threadPool);
+#endif
 
 	SetTraceLogLevel(LOG_WARNING);
 
-	InitWindow(windowInfo.width, windowInfo.height, windowInfo.title.c_str());
-	SetExitKey(KEY_NULL);
+	m_headless = windowInfo.headless;
+
+	if (m_headless)
+	{
+		HeadlessResourceManager();
+	}
+
+	else
+	{
+		SetFlags(windowInfo);
+
+		InitWindow(windowInfo.width, windowInfo.height, windowInfo.title.c_str());
+		SetExitKey(KEY_NULL);
 
-	InitAudioDevice();
+		InitAudioDevice();
 
-	RaylibResourceManager();
+		RaylibResourceManager();
+	}
 
 	// Systems
 	m_systemManager.AddSystem<InputSystem>(0);
@@ -32,19 +54,34 @@ m_renderer(m_registry, windowInfo.virtualWidth, windowInfo.virtualHeight)
 	m_systemManager.AddSystem<AnimationSystem>(0);
 
 	// Basic input
-	m_systemManager.GetSystem<InputSystem>()->BindInput("Cursor", {InputType::POSITION, InputObject::MOUSE});
+	m_systemManager.GetHandle<InputSystem>()->BindInput("Cursor", {InputType::POSITION, InputObject::MOUSE});
 
 	// Set event catcher
 	m_dispatcher.sink<Event::CloseGame>().connect<&Engine::OnCloseGameEvent>(this);
 
+	m_systemManager.SetBudgetCallback(
+	[this](const std::string& system, const bool draw, const double time, const double budget)
+	{
+		m_dispatcher.trigger(Event::SystemOverBudget{system, draw, time, budget});
+	});
+
 	m_virtualWidth = windowInfo.virtualWidth;
 	m_virtualHeight = windowInfo.virtualHeight;
-	m_canvas = LoadRenderTexture(m_virtualWidth, m_virtualHeight);
+
+	if (!m_headless)
+	{
+		CreateCanvas();
+	}
 }
 
 Engine::~Engine()
 {
-	UnloadRenderTexture(m_canvas);
+	if (!m_headless)
+	{
+		UnloadRenderTexture(m_canvas);
+
+		m_renderer.m_spriteBatch.Unload();
+	}
 
 	m_registry.GetRegistry().clear();
 
@@ -52,9 +89,12 @@ Engine::~Engine()
 	m_sceneManager.ClearScenes();
 	m_resourceManager.ClearCaches();
 
-	CloseAudioDevice();
+	if (!m_headless)
+	{
+		CloseAudioDevice();
 
-	CloseWindow();
+		CloseWindow();
+	}
 
 	s_engine = nullptr;
 }
@@ -69,91 +109,580 @@ void Engine::Run(const u32 targetFps, const u32 updateFrequency, const u8 maxUpd
 
 	Assert(maxUpdatesPerFrame, "Must have at least one update per frame");
 
-	SetTargetFPS(targetFps);
+	m_fixedTimeStep = std::max(1.0f / updateFrequency, 1.0f / targetFps);
+	m_maxUpdatesPerFrame = maxUpdatesPerFrame;
+	m_accumulator = 0;
 
-	const float timeStep = std::max(1.0f / updateFrequency, 1.0f / targetFps);
-	float accumulator = 0.0;
+	if (m_headless)
+	{
+		RunHeadless(targetFps);
+		return;
+	}
+
+	SetTargetFPS(targetFps);
 
 	RollingAverage<double> updateTimeAverage;
 	RollingAverage<double> drawTimeAverage;
 
+	const SystemHandle<InputSystem> inputSystem = m_systemManager.GetHandle<InputSystem>();
+
+	// Enough steps to cover the longest frame, 0.1s
+	const u8 idleMaxUpdatesPerFrame =
+	std::max<u32>(maxUpdatesPerFrame, static_cast<u32>(std::ceil(0.1f / m_fixedTimeStep)) + 1);
+
+	m_idle = false;
+
+#ifndef __EMSCRIPTEN__
+	if (m_pipelined)
+	{
+		m_simulationStop = false;
+		m_simulationThread = std::thread(&Engine::SimulationLoop, this);
+	}
+#endif
+
 	while (m_running && !WindowShouldClose())
 	{
-		float deltaT = std::min(GetFrameTime(), 0.1f);
-		accumulator += deltaT;
+		TRACE_FRAME();
+		TRACE_SCOPE("Frame");
 
-		Stopwatch updateTimer;
-		updateTimer.Start();
+		// When pipelined the simulation is idle until released below
+		m_registry.ResetFrameStats();
+		m_frameArena.Reset();
 
-		// Scaling
-		float scaleX;
-		float scaleY;
-		float scale = 1;
-		Vector2 offset;
+		m_drawSimulationTime = 0;
+
+		float deltaT = std::min(GetFrameTime(), 0.1f);
 
+		// Scaling
 		static bool s_computedRescale = false;
 		if (IsWindowResized() || !s_computedRescale)
 		{
-			scaleX = GetRenderWidth() / static_cast<float>(m_virtualWidth);
-			scaleY = GetRenderHeight() / static_cast<float>(m_virtualHeight);
-			scale = std::min(scaleX, scaleY);
+			const float scaleX = GetRenderWidth() / static_cast<float>(m_virtualWidth);
+			const float scaleY = GetRenderHeight() / static_cast<float>(m_virtualHeight);
+			m_windowScale = std::min(scaleX, scaleY);
+
+			m_windowOffset = {static_cast<float>((GetRenderWidth() - (m_virtualWidth * m_windowScale)) * 0.5),
+			static_cast<float>((GetRenderHeight() - (m_virtualHeight * m_windowScale)) * 0.5)};
 
-			offset = {static_cast<float>((GetRenderWidth() - (m_virtualWidth * scale)) * 0.5),
-			static_cast<float>((GetRenderHeight() - (m_virtualHeight * scale)) * 0.5)};
+			// The window shows the virtual canvas pixel for pixel so it can be drawn to directly
+			m_windowMatchesCanvas = static_cast<u32>(GetRenderWidth()) == m_virtualWidth &&
+			static_cast<u32>(GetRenderHeight()) == m_virtualHeight && GetScreenWidth() == GetRenderWidth() &&
+			GetScreenHeight() == GetRenderHeight();
 
 			s_computedRescale = true;
 		}
 
-		INPUT_SYSTEM->SetScaling(scale, offset);
+		inputSystem->SetScaling(m_windowScale, m_windowOffset);
 
-		u8 steps = 0;
-		while (accumulator >= timeStep && steps < maxUpdatesPerFrame)
+		// Idle frames are long, let them run every step that is due
+		m_maxUpdatesPerFrame = m_idle ? idleMaxUpdatesPerFrame : maxUpdatesPerFrame;
+
+		// An idle pipelined frame has nothing to overlap the simulation with
+		const bool simulate = !m_pipelined || m_idle;
+		if (simulate)
 		{
-			m_systemManager.Update(timeStep);
+			Stopwatch updateTimer;
+			updateTimer.Start();
+
+			Simulate(deltaT);
+
+			updateTimeAverage += updateTimer.Stop();
+			m_updateTime = updateTimeAverage.Average();
+
+			UpdateIdle(targetFps);
+		}
+
+		BeginDrawing();
+		ClearBackground(BLANK);
+
+		if (m_windowMatchesCanvas && m_resolutionScale == 1 && !m_idleThrottling)
+		{
+			TRACE_SCOPE("Backbuffer");
+
+			DrawFrame(deltaT, !simulate);
+		}
+
+		else
+		{
+			// When idle the last canvas is presented again instead of being redrawn
+			if (!m_idle)
+			{
+				BeginTextureMode(m_canvas);
+				{
+					TRACE_SCOPE("Canvas");
+
+					ClearBackground(BLANK);
+
+					// Keep drawing in virtual coordinates whatever the canvas resolution
+					rlMatrixMode(RL_PROJECTION);
+					rlLoadIdentity();
+					rlOrtho(0, m_virtualWidth, m_virtualHeight, 0, 0, 1);
+					rlMatrixMode(RL_MODELVIEW);
+
+					DrawFrame(deltaT, !simulate);
+				}
+				EndTextureMode();
+			}
+
+			TRACE_SCOPE("Present");
+
+			DrawTexturePro(m_canvas.texture,
+			{0, 0, static_cast<float>(m_canvas.texture.width), static_cast<float>(-m_canvas.texture.height)},
+			{m_windowOffset.x, m_windowOffset.y, m_virtualWidth * m_windowScale, m_virtualHeight * m_windowScale},
+			{0, 0}, 0, WHITE);
+		}
+
+		EndDrawing();
+
+#ifndef __EMSCRIPTEN__
+		if (!simulate)
+		{
+			updateTimeAverage += m_simulationTime;
+			m_updateTime = updateTimeAverage.Average();
+
+			UpdateIdle(targetFps);
+		}
+#endif
+
+		// The resolution only helps with rendering, so leave out time spent on the simulation while drawing
+		const double drawTime = std::max(GetDrawingTime() * 1000 - m_drawSimulationTime, 0.0);
+
+		drawTimeAverage += drawTime;
+		m_drawTime = drawTimeAverage.Average();
+
+		// Idle frames barely draw and would raise the resolution for no reason
+		if (!m_idle)
+		{
+			UpdateResolutionScale(drawTime);
+		}
+	}
+
+#ifndef __EMSCRIPTEN__
+	if (m_simulationThread.joinable())
+	{
+		m_simulationStop = true;
+		m_simulationStart.release();
+
+		m_simulationThread.join();
+	}
+#endif
+}
+
+void Engine::DrawFrame([[maybe_unused]] const float deltaT, [[maybe_unused]] const bool simulate)
+{
+	m_drawingSnapshot = false;
+
+#ifndef __EMSCRIPTEN__
+	if (simulate)
+	{
+		// Main thread systems, Lua and scenes may call raylib, so they update here while the simulation is idle
+		Stopwatch timer;
+		timer.Start();
+
+		m_simulationSteps = TakeSteps(deltaT);
+
+		for (u8 i = 0; i < m_simulationSteps; i++)
+		{
+			Step(SystemManager::Threads::MAIN_THREAD);
+		}
+
+		const double mainThreadTime = timer.Stop();
+		m_simulationTime = mainThreadTime;
+
+		// Extract the last simulated tick, then run the pooled systems of the next one while drawing it
+		RenderSnapshot& snapshot = m_snapshots[m_snapshotIndex];
+		m_snapshotIndex = (m_snapshotIndex + 1) % m_snapshots.size();
+
+		snapshot.Clear();
+		m_renderer.Extract(m_registry, snapshot);
+		m_systemManager.Extract(snapshot);
+
+		m_simulationStart.release();
+
+		m_renderer.DrawSnapshot(snapshot);
+		m_drawingSnapshot = true;
+
+		{
+			TRACE_SCOPE("WaitForSimulation");
+
+			Stopwatch waitTimer;
+			waitTimer.Start();
+
+			m_simulationDone.acquire();
+
+			m_drawSimulationTime += mainThreadTime + waitTimer.Stop();
+		}
+	}
+
+	else
+#endif
+	{
+		m_renderer.Draw(m_registry);
+	}
+
+	// When pipelined these see the state just simulated, a tick ahead of the snapshot
+	m_systemManager.Draw();
+
+	m_sceneManager.Draw();
+}
+
+void Engine::CreateCanvas()
+{
+	if (IsRenderTextureValid(m_canvas))
+	{
+		UnloadRenderTexture(m_canvas);
+	}
+
+	const i32 width = std::max(1, static_cast<i32>(std::round(m_virtualWidth * m_resolutionScale)));
+	const i32 height = std::max(1, static_cast<i32>(std::round(m_virtualHeight * m_resolutionScale)));
 
-			m_luaManager.Update(timeStep);
+	m_canvas = LoadRenderTexture(width, height);
+
+	// Smooths the upscale of a reduced canvas
+	SetTextureFilter(m_canvas.texture, m_resolutionScale < 1 ? TEXTURE_FILTER_BILINEAR : TEXTURE_FILTER_POINT);
+}
+
+void Engine::UpdateResolutionScale(const double drawTime)
+{
+	if (m_targetDrawTime <= 0)
+	{
+		return;
+	}
+
+	// Count consecutive frames over budget (positive) or comfortably under it (negative)
+	if (drawTime > m_targetDrawTime)
+	{
+		m_resolutionFrames = std::max(m_resolutionFrames, 0) + 1;
+	}
+
+	else if (drawTime < m_targetDrawTime * RESOLUTION_RAISE_MARGIN)
+	{
+		m_resolutionFrames = std::min(m_resolutionFrames, 0) - 1;
+	}
+
+	else
+	{
+		m_resolutionFrames = 0;
+	}
+
+	float scale = m_resolutionScale;
+
+	if (m_resolutionFrames >= RESOLUTION_LOWER_FRAMES)
+	{
+		scale -= RESOLUTION_STEP;
+	}
+
+	else if (m_resolutionFrames <= -RESOLUTION_RAISE_FRAMES)
+	{
+		scale += RESOLUTION_STEP;
+	}
+
+	scale = std::clamp(scale, m_minResolutionScale, 1.0f);
+
+	// Steps don't add up exactly, snap back so the direct path can be taken again
+	if (scale > 1 - (RESOLUTION_STEP * 0.5f))
+	{
+		scale = 1;
+	}
+
+	if (scale != m_resolutionScale)
+	{
+		m_resolutionScale = scale;
+		m_resolutionFrames = 0;
+
+		CreateCanvas();
+	}
+}
+
+void Engine::SetDynamicResolution(const double targetDrawTime, const float minScale)
+{
+	Assert(targetDrawTime >= 0, "Target draw time must not be negative");
+	Assert(minScale > 0 && minScale <= 1, "Minimum resolution scale must be in (0, 1]");
 
-			m_sceneManager.Update(timeStep);
+	m_targetDrawTime = targetDrawTime;
+	m_minResolutionScale = minScale;
+	m_resolutionFrames = 0;
 
-			accumulator -= timeStep;
-			steps++;
+	const float scale = targetDrawTime > 0 ? std::max(m_resolutionScale, minScale) : 1.0f;
+
+	if (scale != m_resolutionScale)
+	{
+		m_resolutionScale = scale;
+
+		if (!m_headless)
+		{
+			CreateCanvas();
 		}
+	}
+}
+
+float Engine::GetResolutionScale() const
+{
+	return m_resolutionScale;
+}
+
+void Engine::SetIdleThrottling(const bool enabled, const u32 idleFps)
+{
+	Assert(idleFps >= 10, "Idle fps must be at least 10");
+
+	m_idleThrottling = enabled;
+	m_idleFps = idleFps;
+}
+
+void Engine::RequestRedraw()
+{
+	m_redrawRequested.store(true, std::memory_order_relaxed);
+}
+
+bool Engine::IsIdle() const
+{
+	return m_idle;
+}
+
+void Engine::UpdateIdle(const u32 targetFps)
+{
+	const bool redrawRequested = m_redrawRequested.exchange(false, std::memory_order_relaxed);
+
+	const bool idle = m_idleThrottling && !redrawRequested && CheckIdle();
+	if (idle == m_idle)
+	{
+		return;
+	}
+
+	m_idle = idle;
+
+	SetTargetFPS(m_idle ? m_idleFps : targetFps);
+}
+
+bool Engine::CheckIdle()
+{
+	if (IsWindowResized() || IsWindowFocused() != m_wasFocused)
+	{
+		m_wasFocused = IsWindowFocused();
+		return false;
+	}
+
+	// Changes made through Emplace, Patch, Replace, MarkChanged or Remove since the frame began
+	if (m_registry.GetFrameChanges<Component::Sprite>() || m_registry.GetFrameChanges<Component::Transform>())
+	{
+		return false;
+	}
 
-		if (steps >= maxUpdatesPerFrame)
+	// Interpolated entities moving in place
+	auto view = m_registry.GetView<Component::PreviousTransform, Component::Transform>();
+	for (auto [entity, previous, transform] : view.each())
+	{
+		if (previous.position.x != transform.position.x || previous.position.y != transform.position.y ||
+			previous.rotation != transform.rotation)
 		{
-			accumulator = 0;
+			return false;
 		}
+	}
 
-		m_renderer.Update(m_registry);
+	return m_renderer.IsIdle() && m_systemManager.IsIdle() && m_sceneManager.IsIdle();
+}
+
+u64 Engine::RunUncapped(const u32 updateFrequency, const u64 steps)
+{
+	Assert(updateFrequency, "Update frequency must be positive");
+
+	m_fixedTimeStep = 1.0f / updateFrequency;
+	m_maxUpdatesPerFrame = 1;
+	m_accumulator = 0;
+
+	RollingAverage<double> updateTimeAverage;
+
+	u64 step = 0;
+	while (m_running && (!steps || step < steps))
+	{
+		TRACE_FRAME();
+
+		m_registry.ResetFrameStats();
+		m_frameArena.Reset();
+
+		Stopwatch updateTimer;
+		updateTimer.Start();
+
+		Simulate(m_fixedTimeStep);
 
 		updateTimeAverage += updateTimer.Stop();
 		m_updateTime = updateTimeAverage.Average();
 
-		BeginDrawing();
-		ClearBackground(BLANK);
+		step++;
+	}
+
+	return step;
+}
+
+bool Engine::IsHeadless() const
+{
+	return m_headless;
+}
+
+void Engine::RunHeadless(const u32 targetFps)
+{
+	using Clock = std::chrono::steady_clock;
+
+	// No window so raylib can't pace or time frames
+	const Clock::duration frameTime =
+	std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+
+	RollingAverage<double> updateTimeAverage;
+
+	Clock::time_point lastFrame = Clock::now();
+	Clock::time_point nextFrame = lastFrame + frameTime;
+
+	while (m_running)
+	{
+		TRACE_FRAME();
+		TRACE_SCOPE("Frame");
+
+		m_registry.ResetFrameStats();
+		m_frameArena.Reset();
+
+		const Clock::time_point now = Clock::now();
+		const float deltaT = std::min(std::chrono::duration<float>(now - lastFrame).count(), 0.1f);
+		lastFrame = now;
+
+		Stopwatch updateTimer;
+		updateTimer.Start();
+
+		Simulate(deltaT);
+
+		updateTimeAverage += updateTimer.Stop();
+		m_updateTime = updateTimeAverage.Average();
+
+		std::this_thread::sleep_until(nextFrame);
+
+		// Don't try to catch up on frames missed by a slow update
+		nextFrame = std::max(nextFrame + frameTime, Clock::now());
+	}
+}
+
+void Engine::Simulate(const float deltaT)
+{
+	TRACE_SCOPE("Engine::Simulate");
+
+	const u8 steps = TakeSteps(deltaT);
+
+	for (u8 i = 0; i < steps; i++)
+	{
+		Step(SystemManager::Threads::ALL);
+	}
+
+	FinishSteps();
+}
+
+u8 Engine::TakeSteps(const float deltaT)
+{
+	m_accumulator += deltaT;
 
-		BeginTextureMode(m_canvas);
+	u8 steps = 0;
+	while (m_accumulator >= m_fixedTimeStep && steps < m_maxUpdatesPerFrame)
+	{
+		m_accumulator -= m_fixedTimeStep;
+		steps++;
+	}
+
+	if (steps >= m_maxUpdatesPerFrame)
+	{
+		m_accumulator = 0;
+	}
+
+	return steps;
+}
+
+void Engine::Step(const SystemManager::Threads threads)
+{
+	TRACE_SCOPE("Step");
+
+	const bool mainThread = threads != SystemManager::Threads::POOLED;
+
+	if (mainThread)
+	{
+		m_registry.AdvanceTick();
+
+		m_registry.ForEach<Component::PreviousTransform, Component::Transform>(
+		[](Component::PreviousTransform& previous, const Component::Transform& transform)
+		{
+			previous.position = transform.position;
+			previous.rotation = transform.rotation;
+		});
+	}
+
+	m_systemManager.Update(m_fixedTimeStep, threads);
+
+	m_registry.PlaybackCommands();
+
+	if (mainThread)
+	{
+		m_luaManager.Update(m_fixedTimeStep);
+
+		m_sceneManager.Update(m_fixedTimeStep);
+
+		m_registry.PlaybackCommands();
+	}
+}
+
+void Engine::FinishSteps()
+{
+	// How far between the last two steps the drawn frame is
+	m_interpolationAlpha = std::clamp(m_accumulator / m_fixedTimeStep, 0.0f, 1.0f);
+
+	m_registry.FlushChanges();
+
+	m_renderer.Update(m_registry);
+}
+
+#ifndef __EMSCRIPTEN__
+void Engine::SimulationLoop()
+{
+	while (true)
+	{
+		m_simulationStart.acquire();
+
+		if (m_simulationStop)
 		{
-			ClearBackground(BLANK);
+			return;
+		}
 
-			m_renderer.Draw(m_registry);
+		TRACE_SCOPE("Engine::Simulate");
 
-			m_systemManager.Draw();
+		Stopwatch timer;
+		timer.Start();
 
-			m_sceneManager.Draw();
+		for (u8 i = 0; i < m_simulationSteps; i++)
+		{
+			Step(SystemManager::Threads::POOLED);
 		}
-		EndTextureMode();
 
-		DrawTexturePro(m_canvas.texture,
-		{0, 0, static_cast<float>(m_canvas.texture.width), static_cast<float>(-m_canvas.texture.height)},
-		{offset.x, offset.y, m_virtualWidth * scale, m_virtualHeight * scale}, {0, 0}, 0, WHITE);
+		FinishSteps();
 
-		EndDrawing();
+		m_simulationTime += timer.Stop();
 
-		drawTimeAverage += GetDrawingTime() * 1000;
-		m_drawTime = drawTimeAverage.Average();
+		m_simulationDone.release();
 	}
 }
+#endif
+
+void Engine::SetPipelined([[maybe_unused]] const bool pipelined)
+{
+#ifndef __EMSCRIPTEN__
+	Assert(!m_simulationThread.joinable(), "Can't change pipelining while running");
+
+	m_pipelined = pipelined;
+#endif
+}
+
+bool Engine::IsPipelined() const
+{
+	return m_pipelined;
+}
+
+bool Engine::IsDrawingSnapshot() const
+{
+	return m_drawingSnapshot;
+}
 
 double Engine::GetUpdateTime() const
 {
@@ -165,6 +694,16 @@ double Engine::GetDrawTime() const
 	return m_drawTime;
 }
 
+float Engine::GetInterpolationAlpha() const
+{
+	return m_interpolationAlpha;
+}
+
+float Engine::GetFixedTimeStep() const
+{
+	return m_fixedTimeStep;
+}
+
 Engine& Engine::Get()
 {
 	Assert(s_engine, "Engine must exists");
@@ -321,6 +860,102 @@ void Engine::RaylibResourceManager()
 	}, UnloadFileData);
 }
 
+void Engine::HeadlessResourceManager()
+{
+	// Stub textures keep their image size so sprites can still be set and measured
+	m_resourceManager.AddCache<Texture2D>([](const std::string& path) -> std::optional<Texture2D>
+	{
+		Image image = LoadImage(path.c_str());
+		if (!IsImageValid(image))
+		{
+			return std::nullopt;
+		}
+
+		Texture2D texture = {.id = 1,
+		.width = image.width,
+		.height = image.height,
+		.mipmaps = image.mipmaps,
+		.format = image.format};
+
+		UnloadImage(image);
+
+		return texture;
+	}, [](Texture2D) {});
+
+	m_resourceManager.AddCache<Image>([](const std::string& path) -> std::optional<Image>
+	{
+		Image image = LoadImage(path.c_str());
+		if (!IsImageValid(image))
+		{
+			return std::nullopt;
+		}
+
+		return image;
+	}, UnloadImage);
+
+	m_resourceManager.AddCache<Wave>([](const std::string& path) -> std::optional<Wave>
+	{
+		Wave wave = LoadWave(path.c_str());
+		if (!IsWaveValid(wave))
+		{
+			return std::nullopt;
+		}
+
+		return wave;
+	}, UnloadWave);
+
+	// Sounds and music need an audio device
+	m_resourceManager.AddCache<Sound>([](const std::string&) -> std::optional<Sound>
+	{
+		return std::nullopt;
+	}, [](Sound) {});
+
+	m_resourceManager.AddCache<Music>([](const std::string&) -> std::optional<Music>
+	{
+		return std::nullopt;
+	}, [](Music) {});
+
+	m_resourceManager.AddCache<char*>([](const std::string& path) -> std::optional<char*>
+	{
+		if (!FileExists(path.c_str()))
+		{
+			return std::nullopt;
+		}
+
+		char* file = LoadFileText(path.c_str());
+
+		if (!file)
+		{
+			return std::nullopt;
+		}
+
+		return file;
+	}, UnloadFileText);
+
+	m_resourceManager.AddCache<u8*>([](const std::string& path) -> std::optional<u8*>
+	{
+		if (!FileExists(path.c_str()))
+		{
+			return std::nullopt;
+		}
+
+		i32 size = GetFileLength(path.c_str());
+		if (size <= 0)
+		{
+			return std::nullopt;
+		}
+
+		u8* file = LoadFileData(path.c_str(), &size);
+
+		if (!file)
+		{
+			return std::nullopt;
+		}
+
+		return file;
+	}, UnloadFileData);
+}
+
 void Engine::OnCloseGameEvent([[maybe_unused]] const Event::CloseGame& event)
 {
 	m_running = false;
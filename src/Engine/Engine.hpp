@@ -3,7 +3,9 @@
 #include "NonCopyable.hpp"
 #include "Types.hpp"
 
+#include "CommandBuffer.hpp"
 #include "Events.hpp"
+#include "FrameArena.hpp"
 #include "LuaManager.hpp"
 #include "Registry.hpp"
 #include "Renderer.hpp"
@@ -22,8 +24,15 @@
 #include "bsThreadPool/BS_thread_pool.hpp"
 #endif
 
+#include <array>
+#include <atomic>
 #include <string>
 
+#ifndef __EMSCRIPTEN__
+#include <semaphore>
+#include <thread>
+#endif
+
 /**
  * @file Engine.hpp
  * @brief Core engine.
@@ -40,6 +49,7 @@ using Dispatcher = entt::dispatcher;
 #define SCENE_MANAGER Engine::Get().sceneManager
 #define SYSTEM_MANAGER Engine::Get().systemManager
 #define LUA_MANAGER Engine::Get().luaManager
+#define FRAME_ARENA Engine::Get().frameArena
 
 #ifndef __EMSCRIPTEN__
 #define NETWORK Engine::Get().network
@@ -47,9 +57,9 @@ using Dispatcher = entt::dispatcher;
 #endif
 
 // Systems
-#define INPUT_SYSTEM SYSTEM_MANAGER.GetSystem<InputSystem>()
-#define AUDIO_SYSTEM SYSTEM_MANAGER.GetSystem<AudioSystem>()
-#define NET_ENTITY_SYSTEM SYSTEM_MANAGER.GetSystem<NetworkEntitySystem>()
+#define INPUT_SYSTEM SYSTEM_MANAGER.GetHandle<InputSystem>()
+#define AUDIO_SYSTEM SYSTEM_MANAGER.GetHandle<AudioSystem>()
+#define NET_ENTITY_SYSTEM SYSTEM_MANAGER.GetHandle<NetworkEntitySystem>()
 
 /**
  * @brief Initial window info
@@ -58,6 +68,10 @@ using Dispatcher = entt::dispatcher;
  *
  * Additionally a virtual window size can be specified to which all elements are drawn.
  * The virtual window is then scaled according to the real window size but aspect ratio is preserved.
+ *
+ * A headless engine opens no window, GL context or audio device. Only the simulation runs,
+ * textures are stubs carrying their image size and sounds and music fail to load. Meant
+ * for dedicated servers and soak or performance runs.
  */
 struct WindowInfo
 {
@@ -77,6 +91,8 @@ struct WindowInfo
 	bool transparent = false;
 	bool highDpi = false;
 	bool msaa4x = false;
+
+	bool headless = false;
 };
 
 /**
@@ -129,17 +145,127 @@ public:
 	 * This is blocking until the window is closed or a CloseGame event is dispatched.
 	 *
 	 * Each frame the loop:
-	 * -# Accumulates elapsed time and runs fixed-timestep Update passes (systems → Lua → scene)
+	 * -# Resets the FrameArena
+	 * -# Accumulates elapsed time and runs fixed-timestep Update passes (systems → Lua → scene),
+	 *    advancing the registry change tick and saving Component::PreviousTransform before and
+	 *    playing back recorded command buffers after the systems and at the end of each step
+	 * -# Notifies observers of components marked with Registry::MarkChanged
 	 * -# Calls the Renderer update (sprite sort)
 	 * -# Draws to the virtual canvas (renderer → systems → scene)
 	 * -# Scales the canvas to the real window and presents it
 	 *
+	 * When the window is exactly the virtual size and the resolution scale is 1 the frame is
+	 * drawn straight to the back buffer, skipping the canvas and its blit, unless idle
+	 * throttling is enabled (see SetIdleThrottling).
+	 *
+	 * When headless only the Update passes run, paced to targetFps with a sleep until the
+	 * next frame, until a CloseGame event is dispatched.
+	 *
+	 * When pipelined (see SetPipelined) each frame the main thread first runs the due steps of
+	 * the main thread systems, Lua and scenes, then extracts the simulated state into a
+	 * RenderSnapshot and releases a simulation thread to run the same steps of the pooled
+	 * systems while the snapshot is drawn. It waits for the simulation before the system and
+	 * scene draws, which therefore see the state a tick ahead of the snapshot.
+	 *
 	 * @param targetFps         Target frames per second
 	 * @param updateFrequency   Fixed update steps per second (must be ≤ targetFps)
 	 * @param maxUpdatesPerFrame Maximum catch-up steps per frame before the accumulator is reset
 	 */
 	void Run(const u32 targetFps, const u32 updateFrequency, const u8 maxUpdatesPerFrame = 5);
 
+	/**
+	 * @brief Runs fixed update steps back to back without waiting or drawing
+	 *
+	 * Blocking until the step count is reached or a CloseGame event is dispatched.
+	 * Each step is simulated as updateFrequency would but without real time passing,
+	 * so thousands of steps per second can be run when headless.
+	 *
+	 * @param updateFrequency Fixed update steps per simulated second
+	 * @param steps           Number of steps to run, 0 to run until closed
+	 * @return Number of steps run
+	 */
+	u64 RunUncapped(const u32 updateFrequency, const u64 steps = 0);
+
+	/**
+	 * @brief Returns true if the engine was created without a window, GL context or audio device
+	 */
+	bool IsHeadless() const;
+
+	/**
+	 * @brief Enables running the simulation on its own thread while the previous state is drawn
+	 *
+	 * Must be called before Run. Systems that declared their access without mainThread
+	 * update on the simulation thread; main thread systems, Lua and scenes still update on
+	 * the main thread, but all of a frame's steps of them run before the pooled systems' steps.
+	 * System and scene Draw run after the simulation, a tick ahead of the drawn sprites, so
+	 * anything that must line up with them should be produced from System::Extract instead.
+	 * Has no effect on Emscripten or when headless.
+	 *
+	 * @param pipelined True to overlap simulation and rendering
+	 */
+	void SetPipelined(const bool pipelined);
+
+	/**
+	 * @brief Returns true if the simulation runs on its own thread
+	 */
+	bool IsPipelined() const;
+
+	/**
+	 * @brief Returns true if this frame's sprites were drawn from a RenderSnapshot
+	 *
+	 * Only then did System::Extract run for the frame, so systems drawing the same
+	 * things from Extract and Draw should skip Draw when this is true. Pipelined
+	 * frames that simulate on the main thread, such as idle ones, draw directly.
+	 */
+	bool IsDrawingSnapshot() const;
+
+	/**
+	 * @brief Lowers the canvas resolution while drawing takes longer than a target
+	 *
+	 * The canvas is rendered at a fraction of the virtual size and scaled up when presented.
+	 * The fraction drops a step after several consecutive frames over the target and rises a
+	 * step after many frames well under it. Drawing stays in virtual coordinates, so cameras
+	 * and input scaling are unaffected.
+	 *
+	 * @param targetDrawTime Draw time to stay under in milliseconds, 0 to disable and restore full resolution
+	 * @param minScale       Lowest fraction of the virtual size to render at
+	 */
+	void SetDynamicResolution(const double targetDrawTime, const float minScale = 0.5f);
+
+	/**
+	 * @brief Returns the fraction of the virtual size the canvas is currently rendered at
+	 */
+	float GetResolutionScale() const;
+
+	/**
+	 * @brief Stops redrawing the canvas and lowers the frame rate while nothing changes
+	 *
+	 * After each simulation the frame counts as idle when no Sprite or Transform was added,
+	 * changed or removed through the registry, no interpolated entity moved, the window was
+	 * not resized or refocused, and the renderer, every system and the current scene report
+	 * being idle. Idle frames present the last canvas again and the loop drops to idleFps,
+	 * running every fixed step that is due so the simulation keeps its pace.
+	 *
+	 * Anything that changes what is drawn in another way, such as writing components in
+	 * place without MarkChanged, should call RequestRedraw.
+	 *
+	 * @param enabled True to throttle idle frames
+	 * @param idleFps Frame rate while idle, at least 10
+	 */
+	void SetIdleThrottling(const bool enabled, const u32 idleFps = 10);
+
+	/**
+	 * @brief Makes the next frame redraw even if nothing else changed
+	 *
+	 * Safe to call from any thread.
+	 */
+	void RequestRedraw();
+
+	/**
+	 * @brief Returns true if the last frame was throttled for being idle
+	 */
+	bool IsIdle() const;
+
 	/**
 	 * @brief Returns how long the average update loop took in milliseconds
 	 */
@@ -147,9 +273,26 @@ public:
 
 	/**
 	 * @brief Returns how long the average draw loop took in milliseconds
+	 *
+	 * When pipelined, the time spent on the simulation while drawing counts as update
+	 * time instead.
 	 */
 	double GetDrawTime() const;
 
+	/**
+	 * @brief Returns how far the drawn frame is between the last two fixed steps
+	 *
+	 * 0 means at the previous step, 1 at the latest one. Draw code uses it to
+	 * interpolate between Component::PreviousTransform and Component::Transform
+	 * so the simulation can run slower than the frame rate without stutter.
+	 */
+	float GetInterpolationAlpha() const;
+
+	/**
+	 * @brief Returns the duration of one fixed update step in seconds
+	 */
+	float GetFixedTimeStep() const;
+
 	/**
 	 * @brief Returns the active engine instance
 	 *
@@ -181,6 +324,9 @@ public:
 	/// Lua scripting manager
 	LuaManager& luaManager = m_luaManager;
 
+	/// Per-frame linear allocator
+	FrameArena& frameArena = m_frameArena;
+
 #ifndef __EMSCRIPTEN__
 	/// Asynchronous networking (unavailable on Emscripten)
 	AsyncNetwork& network = m_network;
@@ -194,6 +340,35 @@ private:
 	static void SetFlags(const WindowInfo& windowInfo);
 
 	void RaylibResourceManager();
+	void HeadlessResourceManager();
+
+	void RunHeadless(const u32 targetFps);
+
+	// Draws the renderer, systems and scene to whatever target is active,
+	// running the simulation alongside when pipelined and it has not run yet
+	void DrawFrame(const float deltaT, const bool simulate);
+
+	void CreateCanvas();
+	void UpdateResolutionScale(const double drawTime);
+
+	void UpdateIdle(const u32 targetFps);
+	bool CheckIdle();
+
+	// Runs the fixed-timestep passes for the elapsed time
+	void Simulate(const float deltaT);
+
+	// Consumes the elapsed time and returns the number of fixed steps due
+	u8 TakeSteps(const float deltaT);
+
+	// Runs one fixed step of the given systems, plus Lua and scenes unless only the pooled ones run
+	void Step(const SystemManager::Threads threads);
+
+	// Updates the interpolation alpha, flushes changes and updates the renderer after the steps
+	void FinishSteps();
+
+#ifndef __EMSCRIPTEN__
+	void SimulationLoop();
+#endif
 
 	// Event handling
 	void OnCloseGameEvent(const Event::CloseGame& event);
@@ -208,6 +383,7 @@ private:
 	SceneManager m_sceneManager;
 	SystemManager m_systemManager;
 	LuaManager m_luaManager;
+	FrameArena m_frameArena;
 
 #ifndef __EMSCRIPTEN__
 	AsyncNetwork m_network;
@@ -217,12 +393,60 @@ private:
 	double m_updateTime = 0;
 	double m_drawTime = 0;
 
+	float m_fixedTimeStep = 0;
+	float m_interpolationAlpha = 1;
+	float m_accumulator = 0;
+	u8 m_maxUpdatesPerFrame = 1;
+
+	// Pipelining
+	bool m_pipelined = false;
+
+	std::array<RenderSnapshot, 2> m_snapshots;
+	u32 m_snapshotIndex = 0;
+	bool m_drawingSnapshot = false;
+
+	// Milliseconds of the frame's drawing spent updating main thread systems or waiting for the simulation
+	double m_drawSimulationTime = 0;
+
+#ifndef __EMSCRIPTEN__
+	std::thread m_simulationThread;
+	std::binary_semaphore m_simulationStart{0};
+	std::binary_semaphore m_simulationDone{0};
+
+	bool m_simulationStop = false;
+	u8 m_simulationSteps = 0;
+	double m_simulationTime = 0;
+#endif
+
 	// Canvas
-	RenderTexture2D m_canvas;
+	RenderTexture2D m_canvas = {};
 	u32 m_virtualWidth = 0;
 	u32 m_virtualHeight = 0;
 
+	float m_windowScale = 1;
+	Vector2 m_windowOffset = {0, 0};
+	bool m_windowMatchesCanvas = false;
+
+	// Dynamic resolution
+	static constexpr float RESOLUTION_STEP = 0.1f;
+	static constexpr i32 RESOLUTION_LOWER_FRAMES = 10;
+	static constexpr i32 RESOLUTION_RAISE_FRAMES = 60;
+	static constexpr double RESOLUTION_RAISE_MARGIN = 0.75;
+
+	double m_targetDrawTime = 0;
+	float m_resolutionScale = 1;
+	float m_minResolutionScale = 0.5f;
+	i32 m_resolutionFrames = 0;
+
+	// Idle throttling
+	bool m_idleThrottling = false;
+	u32 m_idleFps = 10;
+	bool m_idle = false;
+	bool m_wasFocused = true;
+	std::atomic<bool> m_redrawRequested = false;
+
 	bool m_running = true;
+	bool m_headless = false;
 
 	static inline Engine* s_engine = nullptr;
 };
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "Lua/MyLua.hpp"
 
+#include <string>
+
 /**
  * @file Events.hpp
  * @brief Engine events.
@@ -37,4 +39,37 @@ namespace Event
 			sol::constructors<CloseGame()>());
 		}
 	};
+
+	/**
+	 * @brief Event signalling that a system went over its time budget
+	 *
+	 * Triggered by the Engine on the main thread after the update or draw in
+	 * which it happened. Budgets are set with SystemManager::SetBudget.
+	 */
+	struct SystemOverBudget
+	{
+		std::string system;
+
+		/// True if Draw went over budget, false for Update
+		bool draw = false;
+
+		/// Time taken in milliseconds
+		double time = 0;
+
+		/// Budget in milliseconds
+		double budget = 0;
+
+		/**
+		 * @brief Registers the SystemOverBudget type with Lua
+		 *
+		 * @param lua Lua state to register into
+		 */
+		static void LuaRegister(sol::state& lua)
+		{
+			Lua::RegisterType<Event::SystemOverBudget>(lua,
+			DemangleWithoutNamespace<Event::SystemOverBudget>().c_str(), sol::constructors<SystemOverBudget()>(),
+			"system", &SystemOverBudget::system, "draw", &SystemOverBudget::draw, "time", &SystemOverBudget::time,
+			"budget", &SystemOverBudget::budget);
+		}
+	};
 }
\ No newline at end of file
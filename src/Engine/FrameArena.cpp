@@ -0,0 +1,148 @@
+#include "FrameArena.hpp"
+
+#include "Assert.hpp"
+
+#include <algorithm>
+#include <bit>
+
+void* FrameArena::Arena::Allocate(const u64 size, const u64 alignment)
+{
+	Assert(std::has_single_bit(alignment), "Alignment must be a power of two");
+
+	while (m_block < m_blocks.size())
+	{
+		Block& block = m_blocks[m_block];
+
+		const u64 address = reinterpret_cast<u64>(block.data.get()) + m_offset;
+		const u64 padding = (alignment - (address % alignment)) % alignment;
+
+		if (m_offset + padding + size <= block.size)
+		{
+			m_offset += padding + size;
+			m_used += size;
+
+			return block.data.get() + m_offset - size;
+		}
+
+		m_block++;
+		m_offset = 0;
+	}
+
+	// Blocks are aligned for any fundamental type, over-aligned requests get extra room
+	const u64 blockSize = std::max(MIN_BLOCK_SIZE, std::bit_ceil(size + alignment));
+
+	m_blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize});
+	m_block = m_blocks.size() - 1;
+	m_offset = 0;
+
+	return Allocate(size, alignment);
+}
+
+void FrameArena::Arena::Reset()
+{
+	if (m_blocks.size() > 1)
+	{
+		const u64 capacity = GetCapacity();
+
+		m_blocks.clear();
+		m_blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(capacity), capacity});
+	}
+
+	m_block = 0;
+	m_offset = 0;
+	m_used = 0;
+}
+
+u64 FrameArena::Arena::GetBytesUsed() const
+{
+	return m_used;
+}
+
+u64 FrameArena::Arena::GetCapacity() const
+{
+	u64 capacity = 0;
+
+	for (const Block& block : m_blocks)
+	{
+		capacity += block.size;
+	}
+
+	return capacity;
+}
+
+void* FrameArena::Arena::do_allocate(const size_t bytes, const size_t alignment)
+{
+	return Allocate(bytes, alignment);
+}
+
+void FrameArena::Arena::do_deallocate([[maybe_unused]] void* pointer, [[maybe_unused]] const size_t bytes,
+[[maybe_unused]] const size_t alignment)
+{
+}
+
+bool FrameArena::Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+FrameArena::FrameArena() :
+m_id(s_nextId++)
+{
+}
+
+FrameArena::Arena& FrameArena::Get()
+{
+	if (t_cache.ownerId != m_id)
+	{
+		std::unique_lock lock(m_mutex);
+
+		m_threads.push_back(std::make_unique<ThreadArenas>());
+
+		t_cache.ownerId = m_id;
+		t_cache.arenas = m_threads.back().get();
+	}
+
+	return t_cache.arenas->arenas[m_frame.load(std::memory_order_relaxed) % 2];
+}
+
+std::pmr::memory_resource* FrameArena::Resource()
+{
+	return &Get();
+}
+
+void FrameArena::Reset()
+{
+	std::unique_lock lock(m_mutex);
+
+	const u32 frame = m_frame.load(std::memory_order_relaxed);
+
+	m_bytesUsed = 0;
+	for (const std::unique_ptr<ThreadArenas>& thread : m_threads)
+	{
+		m_bytesUsed += thread->arenas[frame % 2].GetBytesUsed();
+
+		// The arena last used two frames ago becomes current
+		thread->arenas[(frame + 1) % 2].Reset();
+	}
+
+	m_frame.store(frame + 1, std::memory_order_relaxed);
+}
+
+u64 FrameArena::GetBytesUsed() const
+{
+	return m_bytesUsed;
+}
+
+u64 FrameArena::GetCapacity()
+{
+	std::unique_lock lock(m_mutex);
+
+	u64 capacity = 0;
+
+	for (const std::unique_ptr<ThreadArenas>& thread : m_threads)
+	{
+		capacity += thread->arenas[0].GetCapacity() + thread->arenas[1].GetCapacity();
+	}
+
+	return capacity;
+}
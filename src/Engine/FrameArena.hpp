@@ -0,0 +1,183 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @file FrameArena.hpp
+ * @brief Per-frame linear allocator.
+ */
+
+/**
+ * @brief Linear allocator for memory that only lives for a frame or two
+ *
+ * Allocating is a pointer bump and freeing does nothing; all memory is released
+ * at once when the Engine resets the arena at the start of every frame. The arena
+ * is double buffered, so memory allocated in one frame stays valid until the end
+ * of the next one.
+ *
+ * Each thread allocates from its own sub-arena, so thread pool tasks can allocate
+ * without locks. Reset must not run while another thread is allocating, which holds
+ * for systems and scenes as the Engine resets between frames. Long running
+ * background tasks must not use the arena.
+ *
+ * Destructors are never run by the arena. Containers using it through Resource
+ * still destroy their elements themselves.
+ *
+ * Usage:
+ * @code
+ * std::pmr::vector<Entity> toDestroy(FRAME_ARENA.Resource());
+ * @endcode
+ */
+class FrameArena : public NonCopyable<>
+{
+public:
+
+	/**
+	 * @brief Single threaded bump allocator usable as a std::pmr::memory_resource
+	 */
+	class Arena : public std::pmr::memory_resource
+	{
+	public:
+
+		/**
+		 * @brief Returns uninitialised memory valid until the arena is reset
+		 *
+		 * @param size      Bytes to allocate
+		 * @param alignment Alignment of the memory, must be a power of two
+		 */
+		void* Allocate(const u64 size, const u64 alignment = alignof(std::max_align_t));
+
+		/**
+		 * @brief Releases everything allocated since the last reset
+		 *
+		 * Blocks are kept, and merged into one if more than one was needed, so a
+		 * steady workload stops allocating from the heap after a few frames.
+		 */
+		void Reset();
+
+		/**
+		 * @brief Returns the bytes allocated since the last reset
+		 */
+		u64 GetBytesUsed() const;
+
+		/**
+		 * @brief Returns the bytes reserved from the heap
+		 */
+		u64 GetCapacity() const;
+
+	private:
+
+		void* do_allocate(const size_t bytes, const size_t alignment) override;
+		void do_deallocate(void* pointer, const size_t bytes, const size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> data;
+			u64 size = 0;
+		};
+
+		static constexpr u64 MIN_BLOCK_SIZE = 64 * 1024;
+
+		std::vector<Block> m_blocks;
+		u64 m_block = 0;
+		u64 m_offset = 0;
+		u64 m_used = 0;
+	};
+
+	/**
+	 * @brief Creates an arena with no thread arenas yet
+	 */
+	FrameArena();
+
+	/**
+	 * @brief Returns the calling thread's arena for the current frame
+	 */
+	Arena& Get();
+
+	/**
+	 * @brief Returns the calling thread's arena for the current frame as a pmr resource
+	 */
+	std::pmr::memory_resource* Resource();
+
+	/**
+	 * @brief Allocates uninitialised storage for count objects of type T
+	 *
+	 * @tparam T Object type
+	 * @param count Number of objects
+	 * @return Pointer to the storage, valid until the end of the next frame
+	 */
+	template <typename T>
+	T* Allocate(const u64 count = 1)
+	{
+		return static_cast<T*>(Get().Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/**
+	 * @brief Constructs an object in the arena
+	 *
+	 * Its destructor is never run, so T should be trivially destructible.
+	 *
+	 * @tparam T Object type
+	 * @param args Constructor arguments
+	 * @return Pointer to the object, valid until the end of the next frame
+	 */
+	template <typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		return new (Allocate<T>()) T(std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief Starts a new frame
+	 *
+	 * Releases the memory allocated two frames ago on every thread. Called by the
+	 * Engine at the start of every frame.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Returns the bytes allocated across all threads in the last frame
+	 */
+	u64 GetBytesUsed() const;
+
+	/**
+	 * @brief Returns the bytes reserved from the heap across all threads
+	 */
+	u64 GetCapacity();
+
+private:
+
+	struct ThreadArenas
+	{
+		std::array<Arena, 2> arenas;
+	};
+
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<ThreadArenas>> m_threads;
+
+	std::atomic<u32> m_frame = 0;
+	u64 m_bytesUsed = 0;
+
+	// Never reused, unlike addresses, so a cache left by a destroyed arena is never mistaken for this one
+	static inline std::atomic<u64> s_nextId = 1;
+	u64 m_id = 0;
+
+	struct ThreadCache
+	{
+		u64 ownerId = 0;
+		ThreadArenas* arenas = nullptr;
+	};
+
+	static inline thread_local ThreadCache t_cache;
+};
@@ -1,5 +1,6 @@
 #include "LuaManager.hpp"
 
+#include "Engine/Trace.hpp"
 #include "sol/sol.hpp"
 #include <optional>
 
@@ -10,6 +11,8 @@ LuaManager::LuaManager()
 
 void LuaManager::Update(const float deltaT)
 {
+	TRACE_SCOPE("LuaManager::Update");
+
 	{
 		std::queue<std::function<void()>> toFlush;
 		{
@@ -30,6 +33,8 @@ void LuaManager::Update(const float deltaT)
 	{
 		if (script.enabled)
 		{
+			TRACE_SCOPE(script.traceName);
+
 			Lua::CallFunction<false>(script.environment, "Update", deltaT);
 		}
 	}
@@ -51,6 +56,7 @@ bool LuaManager::LoadScript(const std::string& path)
 
 	std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
 	script.directory = directory;
+	script.traceName = Trace::Intern(path);
 	script.environment = Lua::CreateEnvironment(lua, true);
 
 	script.environment["require"] = [this, directory](const std::string& modPath) -> sol::object
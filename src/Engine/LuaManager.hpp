@@ -29,6 +29,9 @@ struct LuaScript
 
 	/// When false the script's Update function is not called each frame
 	bool enabled = true;
+
+	/// Interned path naming the script's Update in traces
+	const char* traceName = nullptr;
 };
 
 /**
@@ -200,15 +203,17 @@ private:
 		// the mutex — avoids deadlock if a script triggers another event.
 		std::unique_lock lock(m_mutex);
 
+		// Built once per event type instead of per script and event
+		static const std::string s_functionName = "On" + DemangleWithoutNamespace<Event>() + "Event";
+
 		for (auto& [path, script] : m_scripts)
 		{
 			if (script.enabled)
 			{
-				std::string functionName = "On" + DemangleWithoutNamespace<Event>() + "Event";
 				Event copy = event;
-				m_pendingEvents.push([&script, functionName, copy]()
+				m_pendingEvents.push([&script, copy]()
 				{
-					Lua::CallFunction<false>(script.environment, functionName.c_str(), copy);
+					Lua::CallFunction<false>(script.environment, s_functionName.c_str(), copy);
 				});
 			}
 		}
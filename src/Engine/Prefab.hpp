@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Assert.hpp"
+#include "Types.hpp"
+
+#include "Engine/Registry.hpp"
+#include "entt/entt.hpp"
+
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * @file Prefab.hpp
+ * @brief Reusable component sets for bulk entity creation.
+ */
+
+/**
+ * @brief A set of component values copied onto entities by Registry::Instantiate
+ *
+ * Capture the components once, then spawn any number of entities from it.
+ * Each component is range inserted into its pool instead of emplaced per entity.
+ *
+ * Usage:
+ * @code
+ * Prefab bullet;
+ * bullet.Add<Component::Transform>().Add<Component::Sprite>(bulletSprite);
+ *
+ * REGISTRY.Instantiate(bullet, 5000, [&](const Entity entity, const u32 index)
+ * {
+ *     REGISTRY.GetMutable<Component::Transform>(entity)->position = positions[index];
+ * });
+ * @endcode
+ */
+class Prefab
+{
+public:
+
+	/**
+	 * @brief Adds a component to the prefab
+	 *
+	 * Asserts if the prefab already holds this component type.
+	 *
+	 * @tparam Component Component type
+	 * @tparam Args Constructor argument types
+	 * @param args Arguments forwarded to the component's constructor
+	 * @return Reference to this prefab for chaining
+	 */
+	template <typename Component, typename... Args>
+	Prefab& Add(Args&&... args)
+	{
+		const u32 type = entt::type_index<Component>::value();
+
+		for (const std::unique_ptr<ComponentBase>& component : m_components)
+		{
+			Assert(component->type != type, "Prefab already holds this component");
+		}
+
+		auto component = std::make_unique<ComponentEntry<Component>>(Component{std::forward<Args>(args)...});
+		component->type = type;
+
+		m_components.push_back(std::move(component));
+
+		return *this;
+	}
+
+	/**
+	 * @brief Returns the stored value of a component for editing
+	 *
+	 * @tparam Component Component type
+	 * @return Pointer to the value, or nullptr if the prefab doesn't hold it
+	 */
+	template <typename Component>
+	Component* Get()
+	{
+		const u32 type = entt::type_index<Component>::value();
+
+		for (const std::unique_ptr<ComponentBase>& component : m_components)
+		{
+			if (component->type == type)
+			{
+				return &static_cast<ComponentEntry<Component>&>(*component).value;
+			}
+		}
+
+		return nullptr;
+	}
+
+private:
+
+	struct ComponentBase
+	{
+		virtual ~ComponentBase() = default;
+
+		virtual void Insert(Registry& registry, std::span<const Entity> entities) const = 0;
+		virtual void Notify(Registry& registry, std::span<const Entity> entities) const = 0;
+
+		u32 type = 0;
+	};
+
+	template <typename Component>
+	struct ComponentEntry : ComponentBase
+	{
+		ComponentEntry(Component&& component) :
+		value(std::move(component))
+		{
+		}
+
+		void Insert(Registry& registry, std::span<const Entity> entities) const override
+		{
+			registry.GetSignals<Component>();
+			registry.m_registry.storage<Component>().insert(entities.begin(), entities.end(), value);
+		}
+
+		void Notify(Registry& registry, std::span<const Entity> entities) const override
+		{
+			registry.NotifyConstructed<Component>(entities);
+		}
+
+		Component value;
+	};
+
+	std::vector<std::unique_ptr<ComponentBase>> m_components;
+
+	friend class Registry;
+};
@@ -1,10 +1,54 @@
 #include "Registry.hpp"
 
+#include "CommandBuffer.hpp"
+#include "Log/Logger.hpp"
+#include "Prefab.hpp"
+
+#include <algorithm>
+
+Registry::Registry() :
+m_id(s_nextId++)
+{
+}
+
+Registry::~Registry() = default;
+
 Entity Registry::CreateEntity()
 {
 	return m_registry.create();
 }
 
+std::vector<Entity> Registry::Instantiate(const Prefab& prefab, const u32 count,
+const std::function<void(const Entity entity, const u32 index)>& initializer)
+{
+	std::vector<Entity> entities(count);
+	m_registry.create(entities.begin(), entities.end());
+
+	m_instantiating = true;
+
+	for (const std::unique_ptr<Prefab::ComponentBase>& component : prefab.m_components)
+	{
+		component->Insert(*this, entities);
+	}
+
+	m_instantiating = false;
+
+	if (initializer)
+	{
+		for (u32 i = 0; i < count; ++i)
+		{
+			initializer(entities[i], i);
+		}
+	}
+
+	for (const std::unique_ptr<Prefab::ComponentBase>& component : prefab.m_components)
+	{
+		component->Notify(*this, entities);
+	}
+
+	return entities;
+}
+
 void Registry::DestroyEntity(const Entity entity)
 {
 	if (m_registry.valid(entity))
@@ -18,6 +62,344 @@ bool Registry::EntityValid(const Entity entity)
 	return m_registry.valid(entity);
 }
 
+void Registry::FlushChanges()
+{
+	// Callbacks may mark further changes of any type, so each type's marks are moved
+	// out of the thread lists before flushing and passes repeat until one flushes nothing
+	static constexpr u32 MAX_PASSES = 16;
+
+	std::vector<Entity> entities;
+
+	for (u32 pass = 0;; ++pass)
+	{
+		if (pass == MAX_PASSES)
+		{
+			Logger::Write<LogLevel::WARN>("Change callbacks keep marking changes, leaving the rest for the next flush");
+			break;
+		}
+
+		bool flushedAny = false;
+
+		for (u32 i = 0;; ++i)
+		{
+			void (*flush)(entt::registry& registry, std::vector<Entity>& entities) = nullptr;
+			bool anyType = false;
+
+			{
+				std::unique_lock lock(m_pendingMutex);
+
+				for (const std::unique_ptr<ThreadChanges>& thread : m_threadChanges)
+				{
+					std::unique_lock threadLock(thread->mutex);
+
+					if (i >= thread->pending.size())
+					{
+						continue;
+					}
+
+					anyType = true;
+
+					PendingChanges& pending = thread->pending[i];
+					if (pending.entities.empty())
+					{
+						continue;
+					}
+
+					entities.insert(entities.end(), pending.entities.begin(), pending.entities.end());
+					pending.entities.clear();
+
+					flush = pending.flush;
+				}
+			}
+
+			if (!anyType)
+			{
+				break;
+			}
+
+			if (entities.empty())
+			{
+				continue;
+			}
+
+			flush(m_registry, entities);
+
+			entities.clear();
+			flushedAny = true;
+		}
+
+		if (!flushedAny)
+		{
+			break;
+		}
+	}
+}
+
+Registry::ThreadChanges& Registry::GetThreadChanges()
+{
+	struct LocalChanges
+	{
+		u64 registryId = 0;
+		ThreadChanges* changes = nullptr;
+	};
+
+	thread_local std::vector<LocalChanges> s_changes;
+
+	for (const LocalChanges& local : s_changes)
+	{
+		if (local.registryId == m_id)
+		{
+			return *local.changes;
+		}
+	}
+
+	std::unique_lock lock(m_pendingMutex);
+
+	m_threadChanges.push_back(std::make_unique<ThreadChanges>());
+	s_changes.push_back({m_id, m_threadChanges.back().get()});
+
+	return *m_threadChanges.back();
+}
+
+RegistryStats Registry::GetStats()
+{
+	RegistryStats stats;
+
+	const auto& entities = m_registry.storage<Entity>();
+	stats.entities = entities.free_list();
+	stats.entityCapacity = entities.capacity();
+	stats.bytes = entities.capacity() * sizeof(Entity);
+
+	for ([[maybe_unused]] auto [id, pool] : m_registry.storage())
+	{
+		if (&pool == &entities)
+		{
+			continue;
+		}
+
+		PoolStats& poolStats = stats.pools.emplace_back();
+		poolStats.name = pool.type().name();
+		poolStats.size = pool.size();
+		poolStats.capacity = pool.capacity();
+		poolStats.bytes = pool.capacity() * sizeof(Entity);
+
+		const u32 index = pool.type().index();
+		if (index < m_signals.size() && m_signals[index] && m_signals[index]->pool == &pool)
+		{
+			m_signals[index]->FillStats(poolStats);
+		}
+
+		stats.bytes += poolStats.bytes;
+	}
+
+	return stats;
+}
+
+void Registry::ResetFrameStats()
+{
+	for (const std::unique_ptr<ComponentSignalsBase>& signals : m_signals)
+	{
+		if (signals)
+		{
+			signals->constructs.store(0, std::memory_order_relaxed);
+			signals->updates.store(0, std::memory_order_relaxed);
+			signals->destroys.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+u64 Registry::GetTick() const
+{
+	return m_tick;
+}
+
+u64 Registry::AdvanceTick()
+{
+	const u64 endedTick = m_tick++;
+
+	if (m_tick > m_changeHistory)
+	{
+		const u64 oldestTick = m_tick - m_changeHistory;
+
+		for (auto& tracker : m_trackers)
+		{
+			if (tracker)
+			{
+				tracker->added.Trim(oldestTick);
+				tracker->changed.Trim(oldestTick);
+				tracker->removed.Trim(oldestTick);
+			}
+		}
+	}
+
+	return endedTick;
+}
+
+u64 Registry::GetOldestTrackedTick() const
+{
+	return m_tick > m_changeHistory ? m_tick - m_changeHistory : 0;
+}
+
+void Registry::SetChangeHistory(const u64 ticks)
+{
+	Assert(ticks, "Change history must be at least one tick");
+
+	m_changeHistory = ticks;
+}
+
+void Registry::ChangeLog::Record(const Entity entity, const u64 tick)
+{
+	const u32 index = entt::to_entity(entity);
+	if (index >= latest.size())
+	{
+		latest.resize(index + 1);
+	}
+
+	ChangeRecord& last = latest[index];
+	if (last.tick == tick && last.entity == entity)
+	{
+		return;
+	}
+
+	last = {tick, entity};
+	records.push_back(last);
+}
+
+void Registry::ChangeLog::Query(const u64 sinceTick, std::vector<Entity>& entities) const
+{
+	auto it = std::upper_bound(records.begin(), records.end(), sinceTick, [](const u64 tick, const ChangeRecord& record)
+	{
+		return tick < record.tick;
+	});
+
+	const u64 first = entities.size();
+
+	// Entities seen by this query, by entity index. Stamped per query so it is never
+	// cleared, and per thread so concurrent queries don't share it
+	struct Visit
+	{
+		u32 stamp = 0;
+		Entity entity = entt::null;
+	};
+
+	thread_local std::vector<Visit> t_visited;
+	thread_local u32 t_stamp = 0;
+
+	if (++t_stamp == 0)
+	{
+		t_visited.assign(t_visited.size(), Visit{});
+		t_stamp = 1;
+	}
+
+	if (t_visited.size() < latest.size())
+	{
+		t_visited.resize(latest.size());
+	}
+
+	// Walk newest first so each entity is reported once, at its most recent record
+	for (auto record = records.end(); record != it;)
+	{
+		--record;
+
+		Visit& visit = t_visited[entt::to_entity(record->entity)];
+
+		if (visit.stamp != t_stamp)
+		{
+			visit = {t_stamp, record->entity};
+			entities.push_back(record->entity);
+
+			continue;
+		}
+
+		if (visit.entity == record->entity)
+		{
+			continue;
+		}
+
+		// A recycled index within the range, rare enough to search what was reported
+		if (std::find(entities.begin() + first, entities.end(), record->entity) == entities.end())
+		{
+			entities.push_back(record->entity);
+		}
+	}
+
+	std::reverse(entities.begin() + first, entities.end());
+}
+
+void Registry::ChangeLog::Trim(const u64 oldestTick)
+{
+	auto it = std::lower_bound(records.begin(), records.end(), oldestTick, [](const ChangeRecord& record, const u64 tick)
+	{
+		return record.tick < tick;
+	});
+
+	// Only erase once a good chunk is stale so trimming stays amortised
+	const u64 stale = it - records.begin();
+	if (stale < 1024 && stale * 2 < records.size())
+	{
+		return;
+	}
+
+	records.erase(records.begin(), it);
+}
+
+CommandBuffer& Registry::GetCommandBuffer()
+{
+	struct LocalBuffer
+	{
+		u64 registryId = 0;
+		CommandBuffer* buffer = nullptr;
+	};
+
+	thread_local std::vector<LocalBuffer> s_buffers;
+
+	for (const LocalBuffer& local : s_buffers)
+	{
+		if (local.registryId == m_id)
+		{
+			return *local.buffer;
+		}
+	}
+
+	std::unique_lock lock(m_commandBufferMutex);
+
+	m_commandBuffers.push_back(std::make_unique<CommandBuffer>());
+	s_buffers.push_back({m_id, m_commandBuffers.back().get()});
+
+	return *m_commandBuffers.back();
+}
+
+void Registry::PlaybackCommands()
+{
+	std::vector<CommandBuffer*> buffers;
+
+	{
+		std::unique_lock lock(m_commandBufferMutex);
+
+		buffers.reserve(m_commandBuffers.size());
+		for (auto& buffer : m_commandBuffers)
+		{
+			buffers.push_back(buffer.get());
+		}
+	}
+
+	// Not holding the lock so callbacks can request a buffer while playing back
+	for (CommandBuffer* buffer : buffers)
+	{
+		if (!buffer->Empty())
+		{
+			buffer->Playback(*this);
+		}
+	}
+}
+
+#ifndef __EMSCRIPTEN__
+void Registry::SetThreadPool(BS::thread_pool<BS::tp::none>* threadPool)
+{
+	m_threadPool = threadPool;
+}
+#endif
+
 entt::registry& Registry::GetRegistry()
 {
 	return m_registry;
@@ -1,16 +1,30 @@
 #pragma once
 
 #include "Assert.hpp"
+#include "Engine/Trace.hpp"
 #include "entt/entt.hpp"
 #include <Types.hpp>
+
+#ifndef __EMSCRIPTEN__
+#include "bsThreadPool/BS_thread_pool.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <functional>
-#include <typeindex>
-#include <unordered_map>
-#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 using Entity = entt::entity;
 
+class CommandBuffer;
+class Prefab;
+
 constexpr Entity NULL_ENTITY = static_cast<Entity>(0);
 
 /**
@@ -18,17 +32,69 @@ constexpr Entity NULL_ENTITY = static_cast<Entity>(0);
  * @brief Engine entt::registry wrapper.
  */
 
+/**
+ * @brief Size and signal activity of one component pool
+ *
+ * Signal counts cover the current frame and are only kept for component types
+ * that have been used through the Registry API.
+ */
+struct PoolStats
+{
+	std::string_view name;
+
+	u64 size = 0;
+	u64 capacity = 0;
+	u64 bytes = 0;
+
+	u32 constructs = 0;
+	u32 updates = 0;
+	u32 destroys = 0;
+
+	u32 constructCallbacks = 0;
+	u32 updateCallbacks = 0;
+	u32 destroyCallbacks = 0;
+};
+
+/**
+ * @brief Snapshot of a registry's memory use and activity, see Registry::GetStats
+ */
+struct RegistryStats
+{
+	u64 entities = 0;
+	u64 entityCapacity = 0;
+
+	// Approximate, counts the packed entity arrays and the component storage
+	u64 bytes = 0;
+
+	std::vector<PoolStats> pools;
+};
+
 /**
  * @brief Wraps entt::registry with a safer, callback-aware API
  *
  * Provides typed component operations and supports registering callbacks
  * for component construction, update, and destruction events.
  * All callbacks are identified by a u32 ID so they can be individually removed.
+ *
+ * Callbacks are stored contiguously per component type in a table indexed by
+ * entt::type_index, so dispatching a signal involves no hash lookups.
+ *
+ * The same table counts construct, update and destroy signals per frame for
+ * every component type used through this API, see GetStats.
  */
 class Registry
 {
 public:
 
+	/// Receives every entity a component was constructed on in one notification
+	using BatchCallback = std::function<void(std::span<const Entity> entities)>;
+
+	Registry();
+	~Registry();
+
+	Registry(const Registry&) = delete;
+	Registry& operator=(const Registry&) = delete;
+
 	/**
 	 * @brief Creates a new entity
 	 *
@@ -36,6 +102,22 @@ public:
 	 */
 	Entity CreateEntity();
 
+	/**
+	 * @brief Creates entities in bulk from a prefab
+	 *
+	 * Entities are created in one go and each prefab component is range inserted
+	 * into its pool. The initializer then runs once per entity, after which
+	 * construct callbacks fire per entity and batch construct callbacks fire once
+	 * per pool, so every observer sees the initialized components.
+	 *
+	 * @param prefab Components to copy onto every new entity
+	 * @param count Number of entities to create
+	 * @param initializer Optional function receiving each entity and its index in the batch
+	 * @return The created entities
+	 */
+	std::vector<Entity> Instantiate(const Prefab& prefab, const u32 count,
+	const std::function<void(const Entity entity, const u32 index)>& initializer = {});
+
 	/**
 	 * @brief Destroys an entity if it is valid
 	 *
@@ -73,6 +155,8 @@ public:
 			return nullptr;
 		}
 
+		GetSignals<Component>();
+
 		return &m_registry.emplace<Component>(entity, std::forward<Args>(args)...);
 	}
 
@@ -91,6 +175,8 @@ public:
 	const Component& EmplaceOrReplace(const Entity entity, Args&&... args)
 	{
 		Assert(EntityValid(entity));
+		GetSignals<Component>();
+
 		return m_registry.emplace_or_replace<Component>(entity, std::forward<Args>(args)...);
 	}
 
@@ -114,6 +200,8 @@ public:
 			return false;
 		}
 
+		GetSignals<Component>();
+
 		m_registry.patch<Component>(entity, func);
 
 		return true;
@@ -139,6 +227,23 @@ public:
 		return ptr;
 	}
 
+	/**
+	 * @brief Gets a mutable pointer to a component on an entity
+	 *
+	 * Does not trigger update callbacks. Call MarkChanged afterwards if observers
+	 * need to be told about the modification.
+	 *
+	 * @tparam Component Component type
+	 * @param entity Target entity
+	 * @return Pointer to the component, or nullptr if the entity does not have it
+	 */
+	template <typename Component>
+	Component* GetMutable(const Entity entity)
+	{
+		Assert(EntityValid(entity));
+		return m_registry.try_get<Component>(entity);
+	}
+
 	/**
 	 * @brief Checks whether an entity has at least one of the given components
 	 *
@@ -187,6 +292,8 @@ public:
 			return nullptr;
 		}
 
+		GetSignals<Component>();
+
 		return &m_registry.replace<Component>(entity, std::forward<Args>(args)...);
 	}
 
@@ -250,6 +357,406 @@ public:
 		return m_registry.group<const Owned...>(entt::get_t<const Get...>{}, entt::exclude_t<Exclude...>{});
 	}
 
+	/**
+	 * @brief Returns a view over all entities that have the given components
+	 *
+	 * Components are exposed as mutable references inside the view. Writing through
+	 * the view does not trigger update callbacks; use MarkChanged for that.
+	 *
+	 * @tparam Components Component types to include in the view
+	 * @return entt view over the matching entities
+	 */
+	template <typename... Components>
+	auto GetMutableView()
+	{
+		return m_registry.view<Components...>();
+	}
+
+	/**
+	 * @brief Returns a group exposing mutable owned and non-owned components
+	 *
+	 * Same as GetGroup but components are writable. Writing through the group does
+	 * not trigger update callbacks; use MarkChanged for that.
+	 *
+	 * @tparam Owned Component types owned (and sorted) by the group
+	 * @tparam Get Additional component types to fetch but not own
+	 * @tparam Exclude Component types that disqualify an entity from the group
+	 * @param get entt::get_t list of non-owned components to include
+	 * @param exclude entt::exclude_t list of components to exclude
+	 * @return entt group over the matching entities
+	 */
+	template <typename... Owned, typename... Get, typename... Exclude>
+	auto GetMutableGroup([[maybe_unused]] entt::get_t<Get...> get = entt::get_t{},
+	[[maybe_unused]] entt::exclude_t<Exclude...> exclude = entt::exclude_t{})
+	{
+		return m_registry.group<Owned...>(entt::get_t<Get...>{}, entt::exclude_t<Exclude...>{});
+	}
+
+	/**
+	 * @brief Calls a function on every entity that has the given components
+	 *
+	 * Components are passed as mutable references so they can be modified in place
+	 * without copying. No update callbacks are triggered; call MarkChanged for every
+	 * entity whose observers should be notified.
+	 *
+	 * Structural changes (creating/destroying entities, adding/removing components
+	 * of the iterated types) are not allowed inside the function.
+	 *
+	 * @tparam Components Component types to iterate
+	 * @param func Called with (Entity, Components&...) or (Components&...)
+	 *
+	 * Usage:
+	 * @code
+	 * registry.ForEach<Component::Transform>([&](const Entity entity, Component::Transform& transform)
+	 * {
+	 * 	transform.position += transform.velocity * deltaT;
+	 * 	registry.MarkChanged<Component::Transform>(entity);
+	 * });
+	 * @endcode
+	 */
+	template <typename... Components, typename Func>
+	void ForEach(Func&& func)
+	{
+		m_registry.view<Components...>().each(std::forward<Func>(func));
+	}
+
+	/**
+	 * @brief Calls a function on every entity that has the given components, in parallel
+	 *
+	 * The entities are split into chunks of grainSize which are run on the engine
+	 * thread pool; the call returns once every chunk is done. Falls back to a plain
+	 * serial loop when there is no thread pool (Emscripten), when everything fits in
+	 * a single chunk, or when called from a thread pool task.
+	 *
+	 * Rules inside the function:
+	 * - Only read and write the components passed in, and only for that entity.
+	 *   Reading other components is fine as long as nobody writes them concurrently.
+	 * - No structural changes (creating/destroying entities, adding/removing
+	 *   components); record them with GetCommandBuffer instead.
+	 * - No Patch, Replace, or anything else that triggers callbacks; use MarkChanged.
+	 *
+	 * @tparam Components Component types to iterate
+	 * @param func Called with (Entity, Components&...) for every matching entity
+	 * @param grainSize Number of candidate entities per chunk
+	 */
+	template <typename... Components, typename Func>
+	void ParallelEach(Func&& func, const u32 grainSize = 1024)
+	{
+		Assert(grainSize, "Grain size must be positive");
+
+		auto view = m_registry.view<Components...>();
+		const auto* handle = view.handle();
+		if (!handle)
+		{
+			return;
+		}
+
+		const u64 size = handle->size();
+
+		auto chunk = [&view, &func, handle](const u64 start, const u64 end)
+		{
+			TRACE_SCOPE("ParallelEach");
+
+			for (u64 i = start; i < end; ++i)
+			{
+				const Entity entity = handle->data()[i];
+				if (!view.contains(entity))
+				{
+					continue;
+				}
+
+				std::apply([&func, entity](auto&... components)
+				{
+					func(entity, components...);
+				}, view.get(entity));
+			}
+		};
+
+#ifndef __EMSCRIPTEN__
+		if (m_threadPool && size > grainSize && !BS::this_thread::get_pool())
+		{
+			const u64 chunks = (size + grainSize - 1) / grainSize;
+			m_threadPool->submit_blocks(static_cast<u64>(0), size, chunk, chunks).wait();
+
+			return;
+		}
+#endif
+
+		chunk(0, size);
+	}
+
+#ifndef __EMSCRIPTEN__
+	/**
+	 * @brief Sets the thread pool used by ParallelEach
+	 *
+	 * Called by the Engine constructor with the engine thread pool.
+	 *
+	 * @param threadPool Pool to run chunks on, or nullptr to always run serially
+	 */
+	void SetThreadPool(BS::thread_pool<BS::tp::none>* threadPool);
+#endif
+
+	/**
+	 * @brief Records that a component was modified in place
+	 *
+	 * The update callbacks for the component are not called immediately. Instead all
+	 * marked entities are collected and notified once, in bulk, by FlushChanges.
+	 * Marking the same entity several times before a flush notifies it only once.
+	 * Safe to call from ParallelEach and other worker threads. Each thread records
+	 * into its own list, so concurrent callers do not contend.
+	 *
+	 * @tparam Component Component type that was modified
+	 * @param entity Entity owning the component
+	 */
+	template <typename Component>
+	void MarkChanged(const Entity entity)
+	{
+		MarkChanged<Component>(std::span<const Entity>(&entity, 1));
+	}
+
+	/**
+	 * @brief Records that a component was modified in place on several entities
+	 *
+	 * Same as calling MarkChanged for each entity, but appends them in one go.
+	 *
+	 * @tparam Component Component type that was modified
+	 * @param entities Entities owning the component
+	 */
+	template <typename Component>
+	void MarkChanged(const std::span<const Entity> entities)
+	{
+		ThreadChanges& changes = GetThreadChanges();
+
+		// Only contended while FlushChanges collects this thread's marks
+		std::unique_lock lock(changes.mutex);
+
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= changes.pending.size())
+		{
+			changes.pending.resize(index + 1);
+		}
+
+		PendingChanges& pending = changes.pending[index];
+		if (!pending.flush)
+		{
+			pending.flush = &Registry::FlushPending<Component>;
+		}
+
+		pending.entities.insert(pending.entities.end(), entities.begin(), entities.end());
+	}
+
+	/**
+	 * @brief Triggers update callbacks for every component marked with MarkChanged
+	 *
+	 * Each marked entity is notified once per component type, even if it was marked
+	 * several times. Entities or components that no longer exist are skipped.
+	 * Changes marked by the callbacks themselves, of any type, are flushed in the
+	 * same call; after 16 passes the rest is left for the next call.
+	 * Called once per frame by the Engine after all Update steps.
+	 */
+	void FlushChanges();
+
+	/**
+	 * @brief Returns how many times a component was added, updated or removed this frame
+	 *
+	 * Counts the signals fired since ResetFrameStats, so writes made in place without
+	 * MarkChanged are not included.
+	 *
+	 * @tparam Component Component type
+	 */
+	template <typename Component>
+	u32 GetFrameChanges()
+	{
+		const ComponentSignals<Component>& signals = GetSignals<Component>();
+
+		return signals.constructs.load(std::memory_order_relaxed) + signals.updates.load(std::memory_order_relaxed) +
+			   signals.destroys.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Creates a component's pool and registry bookkeeping up front
+	 *
+	 * They are otherwise created on first use, which resizes tables shared by every
+	 * component type and is not safe while systems run concurrently. SystemManager
+	 * prepares every component a system declares in its SystemAccess.
+	 *
+	 * @tparam Component Component type
+	 */
+	template <typename Component>
+	void Prepare()
+	{
+		GetSignals<Component>();
+
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= m_trackers.size())
+		{
+			m_trackers.resize(index + 1);
+		}
+	}
+
+	/**
+	 * @brief Starts recording when components of a type are added, changed, and removed
+	 *
+	 * Once enabled, every construction, update (Patch, Replace, MarkChanged) and
+	 * destruction of the component is stamped with the current tick so it can be
+	 * queried with GetChangedView, GetAddedView and GetRemovedView.
+	 * Does nothing if tracking is already enabled for the type.
+	 *
+	 * @tparam Component Component type to track
+	 */
+	template <typename Component>
+	void EnableChangeTracking()
+	{
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= m_trackers.size())
+		{
+			m_trackers.resize(index + 1);
+		}
+
+		if (m_trackers[index])
+		{
+			return;
+		}
+
+		m_trackers[index] = std::make_unique<ChangeTracker>();
+
+		m_registry.on_construct<Component>().template connect<&Registry::TrackConstruct<Component>>(this);
+		m_registry.on_update<Component>().template connect<&Registry::TrackUpdate<Component>>(this);
+		m_registry.on_destroy<Component>().template connect<&Registry::TrackDestroy<Component>>(this);
+	}
+
+	/**
+	 * @brief Returns the current change tick
+	 *
+	 * @return Tick that changes are currently being stamped with
+	 */
+	u64 GetTick() const;
+
+	/**
+	 * @brief Starts a new change tick
+	 *
+	 * Called by the Engine before every fixed update step. Reactive code that wants
+	 * to see every change exactly once can also call it right after querying and
+	 * pass the returned tick to its next query.
+	 *
+	 * @return The tick that just ended
+	 *
+	 * Usage:
+	 * @code
+	 * for (const Entity entity : REGISTRY.GetChangedView<Component::Transform>(m_lastTick))
+	 * {
+	 * 	...
+	 * }
+	 *
+	 * m_lastTick = REGISTRY.AdvanceTick();
+	 * @endcode
+	 */
+	u64 AdvanceTick();
+
+	/**
+	 * @brief Sets how many ticks of change history are kept
+	 *
+	 * Queries reaching further back than this only return what is still kept.
+	 *
+	 * @param ticks Number of ticks to keep (default 1024)
+	 */
+	void SetChangeHistory(const u64 ticks);
+
+	/**
+	 * @brief Returns the oldest tick whose changes are still guaranteed to be kept
+	 *
+	 * Queries with a sinceTick before this tick minus one may miss changes.
+	 */
+	u64 GetOldestTrackedTick() const;
+
+	/**
+	 * @brief Returns entities whose component was added or changed after a tick
+	 *
+	 * Requires EnableChangeTracking for the component. Each entity is returned once
+	 * and only if it still has the component.
+	 *
+	 * @tparam Component Tracked component type
+	 * @param sinceTick Only changes stamped with a later tick are returned
+	 * @return Changed entities, in the order they were last changed
+	 */
+	template <typename Component>
+	std::vector<Entity> GetChangedView(const u64 sinceTick)
+	{
+		std::vector<Entity> entities;
+
+		const ChangeTracker& tracker = GetTracker<Component>();
+		tracker.changed.Query(sinceTick, entities);
+
+		FilterExisting<Component>(entities);
+
+		return entities;
+	}
+
+	/**
+	 * @brief Returns entities that gained the component after a tick
+	 *
+	 * Requires EnableChangeTracking for the component. Each entity is returned once
+	 * and only if it still has the component.
+	 *
+	 * @tparam Component Tracked component type
+	 * @param sinceTick Only additions stamped with a later tick are returned
+	 * @return Entities the component was added to
+	 */
+	template <typename Component>
+	std::vector<Entity> GetAddedView(const u64 sinceTick)
+	{
+		std::vector<Entity> entities;
+
+		const ChangeTracker& tracker = GetTracker<Component>();
+		tracker.added.Query(sinceTick, entities);
+
+		FilterExisting<Component>(entities);
+
+		return entities;
+	}
+
+	/**
+	 * @brief Returns entities that lost the component after a tick
+	 *
+	 * Requires EnableChangeTracking for the component. Includes entities that were
+	 * destroyed. An entity that got the component back afterwards is still returned.
+	 *
+	 * @tparam Component Tracked component type
+	 * @param sinceTick Only removals stamped with a later tick are returned
+	 * @return Entities the component was removed from
+	 */
+	template <typename Component>
+	std::vector<Entity> GetRemovedView(const u64 sinceTick)
+	{
+		std::vector<Entity> entities;
+
+		const ChangeTracker& tracker = GetTracker<Component>();
+		tracker.removed.Query(sinceTick, entities);
+
+		return entities;
+	}
+
+	/**
+	 * @brief Returns the calling thread's command buffer for this registry
+	 *
+	 * Each thread records into its own buffer, so this is safe to call from
+	 * thread pool tasks and from inside view iteration. Recorded commands are
+	 * applied by PlaybackCommands.
+	 *
+	 * @return Command buffer owned by this registry for the calling thread
+	 */
+	CommandBuffer& GetCommandBuffer();
+
+	/**
+	 * @brief Applies the commands recorded in every thread's command buffer
+	 *
+	 * Buffers are played back one after another in the order the threads first
+	 * requested them. Must only be called from the main thread while no other
+	 * thread is recording. The Engine calls this after the systems and at the end
+	 * of every fixed update step.
+	 */
+	void PlaybackCommands();
+
 	/**
 	 * @brief Sorts a component pool using a comparator
 	 *
@@ -264,6 +771,23 @@ public:
 		m_registry.sort<Component>(comparitor);
 	}
 
+	/**
+	 * @brief Sorts a component pool using an entity comparator and sort algorithm
+	 *
+	 * Lets callers compare precomputed keys instead of whole components, and pick
+	 * an algorithm suited to the data such as entt::insertion_sort for pools that
+	 * are already nearly sorted.
+	 *
+	 * @tparam Component Component type whose pool is sorted
+	 * @param compare Comparator receiving two entities
+	 * @param algorithm Sort algorithm, entt::std_sort by default
+	 */
+	template <typename Component, typename Compare, typename Algorithm = entt::std_sort>
+	void SortEntities(Compare compare, Algorithm algorithm = Algorithm{})
+	{
+		m_registry.sort<Component>(std::move(compare), std::move(algorithm));
+	}
+
 	/**
 	 * @brief Sorts a group's entities using an entity comparator
 	 *
@@ -298,23 +822,27 @@ public:
 	template <typename Component>
 	u32 OnConstruct(const std::function<void(Component& component, const Entity entity)>& callback)
 	{
-		m_callbackId++;
-
-		auto& callbacks = m_constructCallbacks[typeid(Component)];
-		callbacks[m_callbackId] = [callback](void* comp, const Entity entity)
-		{
-			callback(*static_cast<Component*>(comp), entity);
-		};
-
-		if (!m_constructConnected.contains(typeid(Component)))
-		{
-			m_registry.on_construct<Component>().template connect<&Registry::HandleConstruct<Component>>(this);
-			m_constructConnected.insert(typeid(Component));
-		}
-
-		return m_callbackId;
+		return AddCallback(GetSignals<Component>().construct, callback);
 	};
 
+	/**
+	 * @brief Registers a callback invoked with the entities a component was constructed on
+	 *
+	 * Instantiate calls it once per pool with the whole batch, any other
+	 * construction calls it with a single entity. Prefer this over OnConstruct
+	 * when the observer only needs to know that something was added.
+	 * The returned ID can be used with RemoveConstructCallback to unregister.
+	 *
+	 * @tparam Component Component type to observe
+	 * @param callback Function receiving the entities that received the component
+	 * @return Callback ID
+	 */
+	template <typename Component>
+	u32 OnConstructBatch(const BatchCallback& callback)
+	{
+		return AddCallback(GetSignals<Component>().constructBatch, callback);
+	}
+
 	/**
 	 * @brief Registers a callback invoked when a component of the given type is updated
 	 *
@@ -328,21 +856,7 @@ public:
 	template <typename Component>
 	u32 OnUpdate(const std::function<void(Component& component, const Entity entity)>& callback)
 	{
-		m_callbackId++;
-
-		auto& callbacks = m_updateCallbacks[typeid(Component)];
-		callbacks[m_callbackId] = [callback](void* comp, const Entity entity)
-		{
-			callback(*static_cast<Component*>(comp), entity);
-		};
-
-		if (!m_updateConnected.contains(typeid(Component)))
-		{
-			m_registry.on_update<Component>().template connect<&Registry::HandleUpdate<Component>>(this);
-			m_updateConnected.insert(typeid(Component));
-		}
-
-		return m_callbackId;
+		return AddCallback(GetSignals<Component>().update, callback);
 	};
 
 	/**
@@ -358,103 +872,73 @@ public:
 	template <typename Component>
 	u32 OnDestroy(const std::function<void(Component& component, const Entity entity)>& callback)
 	{
-		m_callbackId++;
-
-		auto& callbacks = m_destroyCallbacks[typeid(Component)];
-		callbacks[m_callbackId] = [callback](void* comp, const Entity entity)
-		{
-			callback(*static_cast<Component*>(comp), entity);
-		};
-
-		if (!m_destroyConnected.contains(typeid(Component)))
-		{
-			m_registry.on_destroy<Component>().template connect<&Registry::HandleDestroy<Component>>(this);
-			m_destroyConnected.insert(typeid(Component));
-		}
-
-		return m_callbackId;
+		return AddCallback(GetSignals<Component>().destroy, callback);
 	};
 
 	/**
 	 * @brief Removes a previously registered construction callback
 	 *
-	 * Disconnects the underlying signal if no more callbacks remain for this type.
-	 *
 	 * @tparam Component Component type the callback was registered for
-	 * @param callbackId ID returned by OnConstruct
+	 * @param callbackId ID returned by OnConstruct or OnConstructBatch
 	 */
 	template <typename Component>
 	void RemoveConstructCallback(const u32 callbackId)
 	{
-		auto it = m_constructCallbacks.find(typeid(Component));
-		if (it == m_constructCallbacks.end())
-		{
-			return;
-		}
-
-		auto& map = it->second;
-		map.erase(callbackId);
-
-		if (map.empty())
+		ComponentSignals<Component>* signals = FindSignals<Component>();
+		if (signals && !RemoveCallback(signals->construct, callbackId))
 		{
-			m_registry.on_construct<Component>().template disconnect<&Registry::HandleConstruct<Component>>(this);
-			m_constructConnected.erase(typeid(Component));
+			RemoveCallback(signals->constructBatch, callbackId);
 		}
 	}
 
 	/**
 	 * @brief Removes a previously registered update callback
 	 *
-	 * Disconnects the underlying signal if no more callbacks remain for this type.
-	 *
 	 * @tparam Component Component type the callback was registered for
 	 * @param callbackId ID returned by OnUpdate
 	 */
 	template <typename Component>
 	void RemoveUpdateCallback(const u32 callbackId)
 	{
-		auto it = m_updateCallbacks.find(typeid(Component));
-		if (it == m_updateCallbacks.end())
+		ComponentSignals<Component>* signals = FindSignals<Component>();
+		if (signals)
 		{
-			return;
-		}
-
-		auto& map = it->second;
-		map.erase(callbackId);
-
-		if (map.empty())
-		{
-			m_registry.on_update<Component>().template disconnect<&Registry::HandleUpdate<Component>>(this);
-			m_updateConnected.erase(typeid(Component));
+			RemoveCallback(signals->update, callbackId);
 		}
 	}
 
 	/**
 	 * @brief Removes a previously registered destruction callback
 	 *
-	 * Disconnects the underlying signal if no more callbacks remain for this type.
-	 *
 	 * @tparam Component Component type the callback was registered for
 	 * @param callbackId ID returned by OnDestroy
 	 */
 	template <typename Component>
 	void RemoveDestroyCallback(const u32 callbackId)
 	{
-		auto it = m_destroyCallbacks.find(typeid(Component));
-		if (it == m_destroyCallbacks.end())
+		ComponentSignals<Component>* signals = FindSignals<Component>();
+		if (signals)
 		{
-			return;
+			RemoveCallback(signals->destroy, callbackId);
 		}
+	}
 
-		auto& map = it->second;
-		map.erase(callbackId);
+	/**
+	 * @brief Returns entity counts, per pool memory use and this frame's signal counts
+	 *
+	 * Walks every pool, so meant for debug overlays and logging rather than
+	 * per entity use.
+	 *
+	 * @return Current statistics
+	 */
+	RegistryStats GetStats();
 
-		if (map.empty())
-		{
-			m_registry.on_destroy<Component>().template disconnect<&Registry::HandleDestroy<Component>>(this);
-			m_destroyConnected.erase(typeid(Component));
-		}
-	}
+	/**
+	 * @brief Zeroes the per frame signal counters
+	 *
+	 * Called by the Engine at the start of every frame.
+	 */
+	void ResetFrameStats();
 
 	/**
 	 * @brief Returns a reference to the underlying entt registry
@@ -469,62 +953,430 @@ public:
 private:
 
 	template <typename Component>
-	void HandleConstruct(entt::registry& registry, Entity entity)
+	using ComponentCallback = std::function<void(Component& component, const Entity entity)>;
+
+	// Callbacks for one signal of one component type, stored contiguously.
+	// ids[i] is the ID of callbacks[i], 0 once removed during a dispatch.
+	template <typename Callback>
+	struct CallbackList
+	{
+		std::vector<u32> ids;
+		std::vector<Callback> callbacks;
+
+		// Callbacks may add and remove callbacks, which is applied once the outermost dispatch ends
+		u32 dispatching = 0;
+		bool removed = false;
+		std::vector<u32> addedIds;
+		std::vector<Callback> added;
+	};
+
+	struct ComponentSignalsBase
+	{
+		virtual ~ComponentSignalsBase() = default;
+
+		virtual void FillStats(PoolStats& stats) const = 0;
+
+		const entt::sparse_set* pool = nullptr;
+
+		// Signals fired this frame, from any thread running systems
+		std::atomic<u32> constructs = 0;
+		std::atomic<u32> updates = 0;
+		std::atomic<u32> destroys = 0;
+	};
+
+	template <typename Component>
+	struct ComponentSignals : ComponentSignalsBase
 	{
-		auto it = m_constructCallbacks.find(typeid(Component));
-		if (it == m_constructCallbacks.end())
+		void FillStats(PoolStats& stats) const override
 		{
-			return;
+			// Empty types have no component storage
+			const u64 componentSize = entt::component_traits<Component>::page_size ? sizeof(Component) : 0;
+			stats.bytes += storage->capacity() * componentSize;
+
+			stats.constructs = constructs.load(std::memory_order_relaxed);
+			stats.updates = updates.load(std::memory_order_relaxed);
+			stats.destroys = destroys.load(std::memory_order_relaxed);
+
+			stats.constructCallbacks = construct.callbacks.size() + constructBatch.callbacks.size();
+			stats.updateCallbacks = update.callbacks.size();
+			stats.destroyCallbacks = destroy.callbacks.size();
+		}
+
+		entt::storage_for_t<Component>* storage = nullptr;
+
+		CallbackList<ComponentCallback<Component>> construct;
+		CallbackList<ComponentCallback<Component>> update;
+		CallbackList<ComponentCallback<Component>> destroy;
+
+		CallbackList<BatchCallback> constructBatch;
+	};
+
+	template <typename Component>
+	ComponentSignals<Component>& GetSignals()
+	{
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= m_signals.size())
+		{
+			m_signals.resize(index + 1);
+		}
+
+		std::unique_ptr<ComponentSignalsBase>& ptr = m_signals[index];
+		if (!ptr)
+		{
+#ifndef __EMSCRIPTEN__
+			Assert(!BS::this_thread::get_pool(), "Component first used on a pool thread, declare it with SystemAccess");
+#endif
+
+			auto signals = std::make_unique<ComponentSignals<Component>>();
+			signals->storage = &m_registry.storage<Component>();
+			signals->pool = signals->storage;
+
+			ptr = std::move(signals);
+
+			// Stay connected for the registry's lifetime so signals are always counted
+			m_registry.on_construct<Component>().template connect<&Registry::HandleConstruct<Component>>(this);
+			m_registry.on_update<Component>().template connect<&Registry::HandleUpdate<Component>>(this);
+			m_registry.on_destroy<Component>().template connect<&Registry::HandleDestroy<Component>>(this);
+		}
+
+		return static_cast<ComponentSignals<Component>&>(*ptr);
+	}
+
+	template <typename Component>
+	ComponentSignals<Component>* FindSignals()
+	{
+		const u32 index = entt::type_index<Component>::value();
+		if (index >= m_signals.size() || !m_signals[index])
+		{
+			return nullptr;
+		}
+
+		return static_cast<ComponentSignals<Component>*>(m_signals[index].get());
+	}
+
+	template <typename Callback>
+	u32 AddCallback(CallbackList<Callback>& list, const Callback& callback)
+	{
+		m_callbackId++;
+
+		// Growing the list would move the callback that is running
+		if (list.dispatching)
+		{
+			list.addedIds.push_back(m_callbackId);
+			list.added.push_back(callback);
+
+			return m_callbackId;
+		}
+
+		list.ids.push_back(m_callbackId);
+		list.callbacks.push_back(callback);
+
+		return m_callbackId;
+	}
+
+	template <typename Callback>
+	static bool RemoveCallback(CallbackList<Callback>& list, const u32 callbackId)
+	{
+		auto it = std::find(list.ids.begin(), list.ids.end(), callbackId);
+		if (it != list.ids.end())
+		{
+			// The callback may be the one running, so it is only skipped until the dispatch ends
+			if (list.dispatching)
+			{
+				*it = 0;
+				list.removed = true;
+
+				return true;
+			}
+
+			const auto index = it - list.ids.begin();
+
+			list.ids.erase(it);
+			list.callbacks.erase(list.callbacks.begin() + index);
+
+			return true;
 		}
 
-		for (auto& pair : it->second)
+		auto added = std::find(list.addedIds.begin(), list.addedIds.end(), callbackId);
+		if (added == list.addedIds.end())
 		{
-			pair.second(static_cast<void*>(&registry.get<Component>(entity)), entity);
+			return false;
+		}
+
+		const auto index = added - list.addedIds.begin();
+
+		list.addedIds.erase(added);
+		list.added.erase(list.added.begin() + index);
+
+		return true;
+	}
+
+	template <typename Callback, typename... Args>
+	static void Dispatch(CallbackList<Callback>& list, Args&&... args)
+	{
+		list.dispatching++;
+
+		for (u64 i = 0; i < list.callbacks.size(); ++i)
+		{
+			// Removed by a callback earlier in this dispatch
+			if (list.ids[i])
+			{
+				list.callbacks[i](args...);
+			}
+		}
+
+		list.dispatching--;
+
+		if (!list.dispatching)
+		{
+			ApplyDeferred(list);
+		}
+	}
+
+	template <typename Callback>
+	static void ApplyDeferred(CallbackList<Callback>& list)
+	{
+		if (list.removed)
+		{
+			u64 kept = 0;
+			for (u64 i = 0; i < list.ids.size(); ++i)
+			{
+				if (list.ids[i])
+				{
+					list.ids[kept] = list.ids[i];
+					list.callbacks[kept] = std::move(list.callbacks[i]);
+					kept++;
+				}
+			}
+
+			list.ids.resize(kept);
+			list.callbacks.resize(kept);
+			list.removed = false;
+		}
+
+		if (!list.added.empty())
+		{
+			list.ids.insert(list.ids.end(), list.addedIds.begin(), list.addedIds.end());
+			list.callbacks.insert(list.callbacks.end(), std::make_move_iterator(list.added.begin()),
+			std::make_move_iterator(list.added.end()));
+
+			list.addedIds.clear();
+			list.added.clear();
 		}
 	}
 
 	template <typename Component>
-	void HandleUpdate(entt::registry& registry, Entity entity)
+	static void DispatchComponent(CallbackList<ComponentCallback<Component>>& list,
+	ComponentSignals<Component>& signals, const Entity entity)
 	{
-		auto it = m_updateCallbacks.find(typeid(Component));
-		if (it == m_updateCallbacks.end())
+		// Empty tag types have no stored instance, their callbacks get a temporary one
+		if constexpr (entt::component_traits<Component>::page_size == 0)
+		{
+			if (!list.callbacks.empty())
+			{
+				Component component{};
+				Dispatch(list, component, entity);
+			}
+		}
+
+		else
+		{
+			Dispatch(list, signals.storage->get(entity), entity);
+		}
+	}
+
+	// Connected when the signals are created, so they are guaranteed to exist
+	template <typename Component>
+	void HandleConstruct([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		auto& signals = static_cast<ComponentSignals<Component>&>(*m_signals[entt::type_index<Component>::value()]);
+		signals.constructs.fetch_add(1, std::memory_order_relaxed);
+
+		// Instantiate notifies once the whole batch is initialized
+		if (m_instantiating)
 		{
 			return;
 		}
 
-		for (auto& pair : it->second)
+		DispatchComponent(signals.construct, signals, entity);
+
+		if (!signals.constructBatch.callbacks.empty())
 		{
-			pair.second(static_cast<void*>(&registry.get<Component>(entity)), entity);
+			std::span<const Entity> entities(&entity, 1);
+			Dispatch(signals.constructBatch, entities);
 		}
 	}
 
+	// Called by Instantiate for each prefab pool once the batch is initialized
 	template <typename Component>
-	void HandleDestroy(entt::registry& registry, Entity entity)
+	void NotifyConstructed(const std::span<const Entity> entities)
 	{
-		auto it = m_destroyCallbacks.find(typeid(Component));
-		if (it == m_destroyCallbacks.end())
+		ComponentSignals<Component>* signals = FindSignals<Component>();
+		if (!signals)
 		{
 			return;
 		}
 
-		for (auto& pair : it->second)
+		if (!signals->construct.callbacks.empty())
+		{
+			for (Entity entity : entities)
+			{
+				// An earlier callback may have removed it again
+				if (signals->storage->contains(entity))
+				{
+					DispatchComponent(signals->construct, *signals, entity);
+				}
+			}
+		}
+
+		Dispatch(signals->constructBatch, entities);
+	}
+
+	template <typename Component>
+	void HandleUpdate([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		auto& signals = static_cast<ComponentSignals<Component>&>(*m_signals[entt::type_index<Component>::value()]);
+		signals.updates.fetch_add(1, std::memory_order_relaxed);
+
+		DispatchComponent(signals.update, signals, entity);
+	}
+
+	template <typename Component>
+	void HandleDestroy([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		auto& signals = static_cast<ComponentSignals<Component>&>(*m_signals[entt::type_index<Component>::value()]);
+		signals.destroys.fetch_add(1, std::memory_order_relaxed);
+
+		DispatchComponent(signals.destroy, signals, entity);
+	}
+
+	template <typename Component>
+	static void FlushPending(entt::registry& registry, std::vector<Entity>& entities)
+	{
+		std::sort(entities.begin(), entities.end());
+		entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+
+		auto& storage = registry.storage<Component>();
+
+		for (const Entity entity : entities)
 		{
-			pair.second(static_cast<void*>(&registry.get<Component>(entity)), entity);
+			if (storage.contains(entity))
+			{
+				registry.patch<Component>(entity);
+			}
 		}
 	}
 
+	struct ChangeRecord
+	{
+		u64 tick = 0;
+		Entity entity = entt::null;
+	};
+
+	// Append only log of (tick, entity) records sorted by tick, plus the latest
+	// record per entity index so repeated changes in a tick are logged once
+	struct ChangeLog
+	{
+		std::vector<ChangeRecord> latest;
+		std::vector<ChangeRecord> records;
+
+		void Record(const Entity entity, const u64 tick);
+		void Query(const u64 sinceTick, std::vector<Entity>& entities) const;
+		void Trim(const u64 oldestTick);
+	};
+
+	struct ChangeTracker
+	{
+		ChangeLog added;
+		ChangeLog changed;
+		ChangeLog removed;
+	};
+
+	template <typename Component>
+	const ChangeTracker& GetTracker() const
+	{
+		const u32 index = entt::type_index<Component>::value();
+		Assert(index < m_trackers.size() && m_trackers[index], "Change tracking is not enabled for this component");
+
+		return *m_trackers[index];
+	}
+
+	template <typename Component>
+	void FilterExisting(std::vector<Entity>& entities)
+	{
+		auto& storage = m_registry.storage<Component>();
+
+		std::erase_if(entities, [&storage](const Entity entity)
+		{
+			return !storage.contains(entity);
+		});
+	}
+
+	template <typename Component>
+	void TrackConstruct([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		ChangeTracker& tracker = *m_trackers[entt::type_index<Component>::value()];
+		tracker.added.Record(entity, m_tick);
+		tracker.changed.Record(entity, m_tick);
+	}
+
+	template <typename Component>
+	void TrackUpdate([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		m_trackers[entt::type_index<Component>::value()]->changed.Record(entity, m_tick);
+	}
+
+	template <typename Component>
+	void TrackDestroy([[maybe_unused]] entt::registry& registry, Entity entity)
+	{
+		m_trackers[entt::type_index<Component>::value()]->removed.Record(entity, m_tick);
+	}
+
+	struct PendingChanges
+	{
+		std::vector<Entity> entities;
+		void (*flush)(entt::registry& registry, std::vector<Entity>& entities) = nullptr;
+	};
+
+	// One thread's MarkChanged records, indexed by entt::type_index of the component
+	struct ThreadChanges
+	{
+		std::mutex mutex;
+		std::vector<PendingChanges> pending;
+	};
+
+	ThreadChanges& GetThreadChanges();
+
 	u32 m_callbackId = 0;
 
-	std::unordered_map<std::type_index, std::unordered_map<u32, std::function<void(void*, const Entity entity)>>>
-	m_constructCallbacks;
-	std::unordered_map<std::type_index, std::unordered_map<u32, std::function<void(void*, const Entity entity)>>>
-	m_updateCallbacks;
-	std::unordered_map<std::type_index, std::unordered_map<u32, std::function<void(void*, const Entity entity)>>>
-	m_destroyCallbacks;
+	// Set while Instantiate inserts into the pools
+	bool m_instantiating = false;
 
-	std::unordered_set<std::type_index> m_constructConnected;
-	std::unordered_set<std::type_index> m_updateConnected;
-	std::unordered_set<std::type_index> m_destroyConnected;
+	u64 m_tick = 1;
+	u64 m_changeHistory = 1024;
+
+	// Indexed by entt::type_index of the component, null when not tracked
+	std::vector<std::unique_ptr<ChangeTracker>> m_trackers;
+
+	// Identifies this registry in the thread local command buffer lookup
+	static inline std::atomic<u64> s_nextId = 1;
+	u64 m_id = 0;
+
+	std::mutex m_commandBufferMutex;
+	std::vector<std::unique_ptr<CommandBuffer>> m_commandBuffers;
+
+	// Guards the list, each thread's records are guarded by their own mutex
+	std::mutex m_pendingMutex;
+	std::vector<std::unique_ptr<ThreadChanges>> m_threadChanges;
+
+#ifndef __EMSCRIPTEN__
+	BS::thread_pool<BS::tp::none>* m_threadPool = nullptr;
+#endif
+
+	// Indexed by entt::type_index of the component
+	std::vector<std::unique_ptr<ComponentSignalsBase>> m_signals;
 
 	entt::registry m_registry;
+
+	friend class Prefab;
 };
\ No newline at end of file
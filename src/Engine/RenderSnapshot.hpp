@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include "raylib.h"
+
+#include <vector>
+
+/**
+ * @file RenderSnapshot.hpp
+ * @brief Extracted draw data for pipelined rendering.
+ */
+
+/**
+ * @brief One textured quad or untextured circle to draw
+ *
+ * Quads are drawn with DrawTexturePro using every field. Circles use the centre
+ * in dest.x and dest.y, the radius in dest.width, and the color.
+ */
+struct RenderItem
+{
+	Texture2D texture = {};
+	Rectangle source = {};
+	Rectangle dest = {};
+	Vector2 origin = {};
+	float rotation = 0;
+	Color color = WHITE;
+
+	bool circle = false;
+};
+
+/**
+ * @brief Everything the renderer needs to draw one simulated tick
+ *
+ * Filled on the main thread while the simulation is idle, then drawn while the
+ * simulation computes the next tick. Holds no references into the registry.
+ * Items are drawn in order.
+ */
+struct RenderSnapshot
+{
+	Camera2D camera = {};
+
+	std::vector<RenderItem> items;
+
+	/**
+	 * @brief Empties the snapshot, keeping its memory for the next extraction
+	 */
+	void Clear()
+	{
+		items.clear();
+	}
+};
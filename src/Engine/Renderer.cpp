@@ -2,10 +2,16 @@
 
 #include "Engine/Engine.hpp"
 #include "Engine/Registry.hpp"
+#include "Engine/Trace.hpp"
 #include "Utils/RaylibUtils.hpp"
 
 #include "Components.hpp"
 #include "raylib.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <mutex>
 
 bool Renderer::SetSprite(const Entity entity, const Component::Sprite& sprite)
 {
@@ -33,6 +39,14 @@ void Renderer::RemoveSprite(const Entity entity)
 	REGISTRY.Remove<Component::Sprite>(entity);
 }
 
+void Renderer::ResetInterpolation(const Entity entity)
+{
+	const Component::Transform* transform = REGISTRY.Get<Component::Transform>(entity);
+	Assert(transform, "Entity has no transform to interpolate");
+
+	REGISTRY.EmplaceOrReplace<Component::PreviousTransform>(entity, transform->position, transform->rotation);
+}
+
 Renderer::Renderer(Registry& registry, const float virtualWidth, const float virtualHeight)
 {
 	Init(registry, virtualWidth, virtualHeight);
@@ -40,34 +54,109 @@ Renderer::Renderer(Registry& registry, const float virtualWidth, const float vir
 
 void Renderer::Update(Registry& registry)
 {
-	if (m_needSort)
+	TRACE_SCOPE("Renderer::Update");
+
+	if (m_spatialCulling)
+	{
+		UpdateGrid(registry);
+	}
+
+	if (!m_unsortedChanges)
+	{
+		return;
+	}
+
+	auto compare = [this](const Entity a, const Entity b)
+	{
+		return m_sortKeys[entt::to_entity(a)] < m_sortKeys[entt::to_entity(b)];
+	};
+
+	// Iterates in the same order as views over sprites
+	const entt::sparse_set& sprites = registry.GetRegistry().storage<Component::Sprite>();
+
+	// Removals and key changes often leave the order intact
+	if (!std::is_sorted(sprites.begin(), sprites.end(), compare))
 	{
-		registry.Sort<Component::Sprite>([](const Component::Sprite& a, const Component::Sprite& b)
+		// Each out of place sprite costs insertion sort up to a pass over the pool
+		if (m_unsortedChanges <= static_cast<u32>(std::bit_width(sprites.size())))
 		{
-			if (a.layer != b.layer)
-			{
-				return a.layer < b.layer;
-			}
+			registry.SortEntities<Component::Sprite>(compare, entt::insertion_sort{});
+		}
+
+		else
+		{
+			registry.SortEntities<Component::Sprite>(compare);
+		}
+	}
 
-			return a.texture.id < b.texture.id;
-		});
+	m_unsortedChanges = 0;
+}
+
+void Renderer::SetSpatialCulling(const bool enabled, const float cellSize)
+{
+	std::unique_lock lock(m_gridMutex);
+
+	m_spatialCulling = enabled;
+	m_grid = SpatialGrid(cellSize);
+	m_gridDirty.clear();
 
-		m_needSort = false;
+	if (!enabled)
+	{
+		return;
+	}
+
+	// Changes while disabled were not recorded, so every sprite starts out dirty
+	auto view = REGISTRY.GetView<Component::Sprite, Component::Transform>();
+	for (const Entity entity : view)
+	{
+		m_gridDirty.push_back(entity);
 	}
 }
 
-void Renderer::Draw(Registry& registry) const
+bool Renderer::IsSpatialCulling() const
+{
+	return m_spatialCulling;
+}
+
+void Renderer::SetYSort(const bool enabled)
+{
+	m_ySort = enabled;
+}
+
+bool Renderer::IsYSorted() const
 {
-	auto view = registry.GetView<Component::Sprite, Component::Transform>();
+	return m_ySort;
+}
 
+u32 Renderer::GetDrawCalls() const
+{
+	return m_spriteBatch.GetDrawCalls();
+}
+
+u32 Renderer::GetSpritesDrawn() const
+{
+	return m_spriteBatch.GetQuads();
+}
+
+bool Renderer::IsIdle() const
+{
+	return camera.target.x == m_drawnCamera.target.x && camera.target.y == m_drawnCamera.target.y &&
+		   camera.offset.x == m_drawnCamera.offset.x && camera.offset.y == m_drawnCamera.offset.y &&
+		   camera.rotation == m_drawnCamera.rotation && camera.zoom == m_drawnCamera.zoom;
+}
+
+template <typename Func>
+void Renderer::ForEachVisibleSprite(Registry& registry, Func&& func) const
+{
 	Rectangle cameraRectangle = {.x = camera.target.x - (camera.offset.x / camera.zoom),
 	.y = camera.target.y - (camera.offset.y / camera.zoom),
 	.width = m_virtualWidth / camera.zoom,
 	.height = m_virtualHeight / camera.zoom};
 
-	BeginMode2D(camera);
+	const float alpha = Engine::Get().GetInterpolationAlpha();
+	const auto& previousTransforms = registry.GetRegistry().storage<Component::PreviousTransform>();
 
-	for (auto [entity, sprite, transform] : view.each())
+	auto visit = [&](const Entity entity, const Component::Sprite& sprite, const Component::Transform& transform)
 	{
 		if (!IsTextureValid(sprite.texture))
 		{
@@ -88,14 +177,237 @@ void Renderer::Draw(Registry& registry) const
 			UnloadImage(image);
 
 			REGISTRY.Replace<Component::Sprite>(entity, newSprite);
+
+			// The placeholder could not be made either, e.g. for an empty rectangle
+			if (!IsTextureValid(newSprite.texture))
+			{
+				return;
+			}
 		}
 
-		if (IsRectangleVisible(sprite.rectangle, sprite.scale, transform.position.Raylib(), cameraRectangle))
+		Vector2 position = transform.position.Raylib();
+		float rotation = transform.rotation;
+
+		if (previousTransforms.contains(entity))
 		{
-			DrawTextureRotScaleSelect(sprite.texture, sprite.rectangle, transform.position.Raylib(), transform.rotation,
-			sprite.scale, sprite.color);
+			const Component::PreviousTransform& previous = previousTransforms.get(entity);
+
+			position.x = previous.position.x + ((position.x - previous.position.x) * alpha);
+			position.y = previous.position.y + ((position.y - previous.position.y) * alpha);
+
+			// Take the short way around
+			const float turn = std::remainder(rotation - previous.rotation, 360.0f);
+			rotation = previous.rotation + (turn * alpha);
 		}
+
+		if (IsRectangleVisible(sprite.rectangle, sprite.scale, position, cameraRectangle))
+		{
+			func(sprite, position, rotation);
+		}
+	};
+
+	if (!m_spatialCulling)
+	{
+		// Iterate in sprite pool order even when fewer entities have transforms
+		auto view = registry.GetView<Component::Sprite, Component::Transform>();
+		view.use<Component::Sprite>();
+
+		for (auto [entity, sprite, transform] : view.each())
+		{
+			visit(entity, sprite, transform);
+		}
+
+		return;
+	}
+
+	TRACE_SCOPE("Renderer::Cull");
+
+	m_candidates.clear();
+	m_grid.Query(cameraRectangle, m_candidates);
+
+	const auto& sprites = registry.GetRegistry().storage<Component::Sprite>();
+	const auto& transforms = registry.GetRegistry().storage<Component::Transform>();
+
+	// Anything removed since the last Update is still in the grid
+	std::erase_if(m_candidates, [&sprites, &transforms](const Entity entity)
+	{
+		return !sprites.contains(entity) || !transforms.contains(entity);
+	});
+
+	// The grid returns candidates in cell order, views iterate the pool from its back
+	std::sort(m_candidates.begin(), m_candidates.end(), [&sprites](const Entity a, const Entity b)
+	{
+		return sprites.index(a) > sprites.index(b);
+	});
+
+	for (const Entity entity : m_candidates)
+	{
+		visit(entity, sprites.get(entity), transforms.get(entity));
+	}
+}
+
+template <typename Func>
+void Renderer::ForEachSpriteInOrder(Registry& registry, Func&& func) const
+{
+	if (!m_ySort)
+	{
+		ForEachVisibleSprite(registry, func);
+
+		return;
+	}
+
+	TRACE_SCOPE("Renderer::YSort");
+
+	m_visible.clear();
+	m_drawKeys.clear();
+
+	ForEachVisibleSprite(registry,
+	[this](const Component::Sprite& sprite, const Vector2 position, const float rotation)
+	{
+		// Flipping the sign bit, or every bit of negatives, makes floats sort as unsigned integers
+		const float bottom = position.y + (sprite.rectangle.height * sprite.scale * 0.5f);
+		u32 depth = std::bit_cast<u32>(bottom);
+		depth ^= (depth >> 31) ? 0xFFFFFFFF : 0x80000000;
+
+		const u64 layer = std::min<u32>(sprite.layer, 0xFFFF);
+		const u64 texture = std::min<u32>(sprite.texture.id, 0xFFFF);
+
+		m_drawKeys.push_back({(layer << 48) | (static_cast<u64>(depth) << 16) | texture,
+		static_cast<u32>(m_visible.size())});
+		m_visible.push_back({&sprite, position, rotation});
+	});
+
+	RadixSort(m_drawKeys, m_drawKeysScratch);
+
+	for (const DrawKey& drawKey : m_drawKeys)
+	{
+		const VisibleSprite& visible = m_visible[drawKey.index];
+
+		func(*visible.sprite, visible.position, visible.rotation);
 	}
+}
+
+void Renderer::RadixSort(std::vector<DrawKey>& keys, std::vector<DrawKey>& scratch)
+{
+	if (keys.size() < 2)
+	{
+		return;
+	}
+
+	scratch.resize(keys.size());
+
+	// One histogram per byte, counted in a single pass
+	std::array<std::array<u32, 256>, 8> counts = {};
+
+	for (const DrawKey& drawKey : keys)
+	{
+		for (u32 byte = 0; byte < 8; byte++)
+		{
+			counts[byte][(drawKey.key >> (byte * 8)) & 0xFF]++;
+		}
+	}
+
+	for (u32 byte = 0; byte < 8; byte++)
+	{
+		std::array<u32, 256>& count = counts[byte];
+
+		// Every key has the same byte here, the pass would not move anything
+		if (count[(keys.front().key >> (byte * 8)) & 0xFF] == keys.size())
+		{
+			continue;
+		}
+
+		u32 offset = 0;
+		for (u32& bucket : count)
+		{
+			const u32 size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+
+		for (const DrawKey& drawKey : keys)
+		{
+			scratch[count[(drawKey.key >> (byte * 8)) & 0xFF]++] = drawKey;
+		}
+
+		keys.swap(scratch);
+	}
+}
+
+void Renderer::Draw(Registry& registry) const
+{
+	TRACE_SCOPE("Renderer::Draw");
+
+	m_drawnCamera = camera;
+	m_spriteBatch.ResetStats();
+
+	BeginMode2D(camera);
+
+	ForEachSpriteInOrder(registry,
+	[this](const Component::Sprite& sprite, const Vector2 position, const float rotation)
+	{
+		// Same placement as DrawTextureRotScaleSelect
+		const float width = sprite.rectangle.width * sprite.scale;
+		const float height = sprite.rectangle.height * sprite.scale;
+
+		m_spriteBatch.Draw(sprite.texture, sprite.rectangle, {position.x, position.y, width, height},
+		{width * 0.5f, height * 0.5f}, rotation, sprite.color);
+	});
+
+	m_spriteBatch.Flush();
+
+	EndMode2D();
+}
+
+void Renderer::Extract(Registry& registry, RenderSnapshot& snapshot) const
+{
+	TRACE_SCOPE("Renderer::Extract");
+
+	m_drawnCamera = camera;
+
+	snapshot.camera = camera;
+
+	ForEachSpriteInOrder(registry,
+	[&snapshot](const Component::Sprite& sprite, const Vector2 position, const float rotation)
+	{
+		// Same placement as DrawTextureRotScaleSelect
+		const float width = sprite.rectangle.width * sprite.scale;
+		const float height = sprite.rectangle.height * sprite.scale;
+
+		snapshot.items.push_back({.texture = sprite.texture,
+		.source = sprite.rectangle,
+		.dest = {position.x, position.y, width, height},
+		.origin = {width * 0.5f, height * 0.5f},
+		.rotation = rotation,
+		.color = sprite.color});
+	});
+}
+
+void Renderer::DrawSnapshot(const RenderSnapshot& snapshot) const
+{
+	TRACE_SCOPE("Renderer::DrawSnapshot");
+
+	m_spriteBatch.ResetStats();
+
+	BeginMode2D(snapshot.camera);
+
+	for (const RenderItem& item : snapshot.items)
+	{
+		if (item.circle)
+		{
+			// Keep the circle after the quads submitted before it
+			m_spriteBatch.Flush();
+
+			DrawCircleV({item.dest.x, item.dest.y}, item.dest.width, item.color);
+		}
+
+		else
+		{
+			m_spriteBatch.Draw(item.texture, item.source, item.dest, item.origin, item.rotation, item.color);
+		}
+	}
+
+	m_spriteBatch.Flush();
 
 	EndMode2D();
 }
@@ -110,23 +422,143 @@ void Renderer::Init(Registry& registry, const float virtualWidth, const float vi
 	m_virtualWidth = virtualWidth;
 	m_virtualHeight = virtualHeight;
 
-	registry.OnConstruct<Component::Sprite>([this](Component::Sprite&, const Entity)
+	// Batched so Instantiate keys the whole batch in one callback
+	registry.OnConstructBatch<Component::Sprite>([this, &registry](std::span<const Entity> entities)
+	{
+		const auto& sprites = registry.GetRegistry().storage<Component::Sprite>();
+
+		for (const Entity entity : entities)
+		{
+			if (sprites.contains(entity))
+			{
+				UpdateSortKey(entity, sprites.get(entity));
+			}
+		}
+
+		m_unsortedChanges += entities.size();
+
+		MarkGridDirty(entities);
+	});
+
+	// Animations replace sprites every frame, only a new layer or texture can move one
+	registry.OnUpdate<Component::Sprite>([this](Component::Sprite& sprite, const Entity entity)
+	{
+		if (UpdateSortKey(entity, sprite))
+		{
+			m_unsortedChanges++;
+		}
+
+		MarkGridDirty({&entity, 1});
+	});
+
+	// The pool fills the hole with its last sprite
+	registry.OnDestroy<Component::Sprite>([this](Component::Sprite&, const Entity entity)
 	{
-		MarkNeedSort();
+		m_unsortedChanges++;
+
+		MarkGridDirty({&entity, 1});
 	});
 
-	registry.OnUpdate<Component::Sprite>([this](Component::Sprite&, const Entity)
+	// Grid bounds also depend on the transform and where it is interpolated from
+	auto markBatch = [this](std::span<const Entity> entities)
 	{
-		MarkNeedSort();
+		MarkGridDirty(entities);
+	};
+
+	registry.OnConstructBatch<Component::Transform>(markBatch);
+	registry.OnConstructBatch<Component::PreviousTransform>(markBatch);
+
+	registry.OnUpdate<Component::Transform>([this](Component::Transform&, const Entity entity)
+	{
+		MarkGridDirty({&entity, 1});
 	});
 
-	registry.OnDestroy<Component::Sprite>([this](Component::Sprite&, const Entity)
+	registry.OnUpdate<Component::PreviousTransform>([this](Component::PreviousTransform&, const Entity entity)
 	{
-		MarkNeedSort();
+		MarkGridDirty({&entity, 1});
 	});
+
+	registry.OnDestroy<Component::Transform>([this](Component::Transform&, const Entity entity)
+	{
+		MarkGridDirty({&entity, 1});
+	});
+}
+
+void Renderer::MarkGridDirty(const std::span<const Entity> entities)
+{
+	if (!m_spatialCulling)
+	{
+		return;
+	}
+
+	// Systems running concurrently can patch sprites and transforms at the same time
+	std::unique_lock lock(m_gridMutex);
+
+	m_gridDirty.insert(m_gridDirty.end(), entities.begin(), entities.end());
+}
+
+void Renderer::UpdateGrid(Registry& registry)
+{
+	TRACE_SCOPE("Renderer::UpdateGrid");
+
+	std::unique_lock lock(m_gridMutex);
+
+	const auto& sprites = registry.GetRegistry().storage<Component::Sprite>();
+	const auto& transforms = registry.GetRegistry().storage<Component::Transform>();
+	const auto& previousTransforms = registry.GetRegistry().storage<Component::PreviousTransform>();
+
+	for (const Entity entity : m_gridDirty)
+	{
+		if (!sprites.contains(entity) || !transforms.contains(entity))
+		{
+			m_grid.Remove(entity);
+
+			continue;
+		}
+
+		const Component::Sprite& sprite = sprites.get(entity);
+		const Vector2 position = transforms.get(entity).position.Raylib();
+
+		// Same worst case square as IsRectangleVisible, any rotation fits inside
+		const float extent = (std::hypot(sprite.rectangle.width, sprite.rectangle.height) * sprite.scale * 0.5f) + 2;
+
+		Rectangle bounds = {position.x - extent, position.y - extent, extent * 2, extent * 2};
+
+		// Interpolated sprites are drawn anywhere between their previous and current position
+		if (previousTransforms.contains(entity))
+		{
+			const Component::PreviousTransform& previous = previousTransforms.get(entity);
+
+			const float minX = std::min(position.x, previous.position.x) - extent;
+			const float minY = std::min(position.y, previous.position.y) - extent;
+			const float maxX = std::max(position.x, previous.position.x) + extent;
+			const float maxY = std::max(position.y, previous.position.y) + extent;
+
+			bounds = {minX, minY, maxX - minX, maxY - minY};
+		}
+
+		m_grid.Update(entity, bounds);
+	}
+
+	m_gridDirty.clear();
 }
 
-void Renderer::MarkNeedSort()
+bool Renderer::UpdateSortKey(const Entity entity, const Component::Sprite& sprite)
 {
-	m_needSort = true;
+	const u64 key = (static_cast<u64>(sprite.layer) << 32) | sprite.texture.id;
+	const u32 index = entt::to_entity(entity);
+
+	if (index >= m_sortKeys.size())
+	{
+		m_sortKeys.resize(std::bit_ceil(index + 1));
+	}
+
+	else if (m_sortKeys[index] == key)
+	{
+		return false;
+	}
+
+	m_sortKeys[index] = key;
+
+	return true;
 }
\ No newline at end of file
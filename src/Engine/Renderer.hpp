@@ -2,9 +2,16 @@
 
 #include "Components.hpp"
 #include "Registry.hpp"
+#include "RenderSnapshot.hpp"
+#include "SpatialGrid.hpp"
+#include "SpriteBatch.hpp"
 #include "entt/entt.hpp"
 #include "raylib.h"
 
+#include <mutex>
+#include <span>
+#include <vector>
+
 /**
  * @file Renderer.hpp
  * @brief Sprite rendering.
@@ -14,7 +21,9 @@
  * @brief Draws all entities with Sprite and Transform components
  *
  * Manages a sorted sprite pool and a 2D camera. Sprites are sorted by layer
- * then by texture ID so draw calls are batched as much as possible.
+ * then by texture ID so draw calls are batched as much as possible. With Y
+ * sorting enabled, visible sprites are instead drawn by layer then by the bottom
+ * edge of the sprite, for top-down games where lower sprites overlap higher ones.
  * Entities missing a valid texture are rendered with a purple/black checkerboard
  * placeholder until one is assigned.
  *
@@ -46,12 +55,70 @@ public:
 	 */
 	static void RemoveSprite(const Entity entity);
 
+	/**
+	 * @brief Enables interpolated drawing for an entity or snaps it to its transform
+	 *
+	 * Sets Component::PreviousTransform to the current Component::Transform. Call
+	 * once to opt in and again after teleporting so the entity doesn't visibly
+	 * slide from its old position. Asserts if the entity has no transform.
+	 *
+	 * @param entity Target entity
+	 */
+	static void ResetInterpolation(const Entity entity);
+
+	/**
+	 * @brief Enables or disables spatial grid culling
+	 *
+	 * When enabled, sprite bounds are kept in a SpatialGrid updated from Sprite,
+	 * Transform and PreviousTransform signals, and drawing only tests the sprites
+	 * in the cells the camera overlaps. Transforms written in place must be marked
+	 * with Registry::MarkChanged, or their sprites may be culled at their old
+	 * position. Enabling rebuilds the grid from every sprite.
+	 *
+	 * @param enabled  True to cull through the grid, false to test every sprite
+	 * @param cellSize Width and height of a grid cell in world units
+	 */
+	void SetSpatialCulling(const bool enabled, const float cellSize = 256);
+
+	/**
+	 * @brief Returns true if spatial grid culling is enabled
+	 */
+	bool IsSpatialCulling() const;
+
+	/**
+	 * @brief Enables or disables Y sorting
+	 *
+	 * When enabled, every frame the visible sprites get a 64-bit key of layer,
+	 * bottom edge Y and texture ID, which is radix sorted in scratch memory.
+	 * The ECS pools are never reordered. Sprites on the same layer and row keep
+	 * batching by texture. Layers and texture IDs above 65535 are clamped.
+	 *
+	 * @param enabled True to draw by layer then Y, false to draw in pool order
+	 */
+	void SetYSort(const bool enabled);
+
+	/**
+	 * @brief Returns true if Y sorting is enabled
+	 */
+	bool IsYSorted() const;
+
+	/**
+	 * @brief Returns the draw calls issued by the last sprite draw
+	 */
+	u32 GetDrawCalls() const;
+
+	/**
+	 * @brief Returns the sprites drawn by the last sprite draw
+	 */
+	u32 GetSpritesDrawn() const;
+
 	/**
 	 * @brief Initialises the renderer and registers sprite change callbacks
 	 *
-	 * Called automatically by the Engine constructor. Registers OnConstruct,
-	 * OnUpdate, and OnDestroy callbacks on Component::Sprite so the sprite pool
-	 * is re-sorted whenever the set of sprites changes.
+	 * Called automatically by the Engine constructor. Registers OnConstructBatch,
+	 * OnUpdate, and OnDestroy callbacks on Component::Sprite that keep a sort key
+	 * per sprite and count the changes that can break the pool's order. Updates
+	 * that only change the source rectangle, tint or scale are free.
 	 *
 	 * @param registry Registry to watch for sprite changes
 	 * @param virtualWidth Width of the virtual canvas in pixels
@@ -64,9 +131,12 @@ private:
 	Renderer(Registry& registry, const float virtualWidth, const float virtualHeight);
 
 	/**
-	 * @brief Re-sorts the sprite pool if any sprite was added, changed, or removed
+	 * @brief Restores the sprite pool order if any sprite was added, re-keyed, or removed
 	 *
-	 * Called once per frame by the Engine before drawing begins.
+	 * Called once per frame by the Engine before drawing begins. A pool that is
+	 * still in order is left alone, a few changes are fixed with an insertion sort
+	 * and anything more falls back to a full sort. With spatial culling, also moves
+	 * the changed sprites within the grid.
 	 *
 	 * @param registry Registry holding the sprite pool
 	 */
@@ -76,22 +146,102 @@ private:
 	 * @brief Draws all visible sprites to the current render target
 	 *
 	 * Iterates entities with Sprite and Transform components in sorted order.
-	 * Sprites outside the camera frustum are culled. Must be called between
-	 * BeginTextureMode / EndTextureMode.
+	 * Sprites outside the camera frustum are culled. Visible sprites go through a
+	 * SpriteBatch, costing one draw call per run of sprites sharing a texture.
+	 * Must be called between BeginTextureMode / EndTextureMode.
 	 *
 	 * @param registry Registry to query for Sprite and Transform components
 	 */
 	void Draw(Registry& registry) const;
 
 	/**
-	 * @brief Marks the sprite pool as needing a re-sort on the next Update
+	 * @brief Copies what Draw would draw into a snapshot
+	 *
+	 * Used by pipelined rendering. Appends the visible sprites in sorted order
+	 * with their interpolated placement and stores the camera.
+	 *
+	 * @param registry Registry to query for Sprite and Transform components
+	 * @param snapshot Snapshot to append to
+	 */
+	void Extract(Registry& registry, RenderSnapshot& snapshot) const;
+
+	/**
+	 * @brief Draws a previously extracted snapshot to the current render target
+	 *
+	 * Touches no registry state, so it can run while the simulation updates.
+	 *
+	 * @param snapshot Snapshot to draw
 	 */
-	void MarkNeedSort();
+	void DrawSnapshot(const RenderSnapshot& snapshot) const;
+
+	/**
+	 * @brief Returns true if the camera hasn't moved since the last Draw or Extract
+	 */
+	bool IsIdle() const;
+
+	// Calls func with every visible sprite and where to draw it
+	template <typename Func>
+	void ForEachVisibleSprite(Registry& registry, Func&& func) const;
+
+	// Same as ForEachVisibleSprite, in draw order
+	template <typename Func>
+	void ForEachSpriteInOrder(Registry& registry, Func&& func) const;
 
-	bool m_needSort = false;
+	struct VisibleSprite
+	{
+		const Component::Sprite* sprite;
+		Vector2 position;
+		float rotation;
+	};
+
+	struct DrawKey
+	{
+		u64 key;
+		u32 index;
+	};
+
+	// Stable least significant digit radix sort, scratch is resized to match
+	static void RadixSort(std::vector<DrawKey>& keys, std::vector<DrawKey>& scratch);
+
+	// Queues entities whose grid bounds must be recomputed on the next Update
+	void MarkGridDirty(const std::span<const Entity> entities);
+
+	// Recomputes the grid bounds of every queued entity
+	void UpdateGrid(Registry& registry);
+
+	// Stores the sprite's (layer, texture) key, returns true if it changed
+	bool UpdateSortKey(const Entity entity, const Component::Sprite& sprite);
+
+	// Sort keys indexed by entity index, stale for destroyed entities
+	std::vector<u64> m_sortKeys;
+
+	// Constructs, destroys and key changes since the pool was last in order
+	u32 m_unsortedChanges = 0;
+
+	bool m_spatialCulling = false;
+
+	SpatialGrid m_grid;
+	std::vector<Entity> m_gridDirty;
+	std::mutex m_gridMutex;
+
+	// Grid query results, kept between frames to reuse the memory
+	mutable std::vector<Entity> m_candidates;
+
+	bool m_ySort = false;
+
+	// Y sort scratch, kept between frames to reuse the memory
+	mutable std::vector<VisibleSprite> m_visible;
+	mutable std::vector<DrawKey> m_drawKeys;
+	mutable std::vector<DrawKey> m_drawKeysScratch;
 
 	float m_virtualWidth = 0;
 	float m_virtualHeight = 0;
 
+	// Camera as of the last draw
+	mutable Camera2D m_drawnCamera = {};
+
+	// Sprites are submitted in sorted (layer, texture) order, one draw call per texture run
+	mutable SpriteBatch m_spriteBatch;
+
 	friend class Engine;
 };
\ No newline at end of file
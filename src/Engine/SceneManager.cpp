@@ -2,6 +2,8 @@
 
 #include "Assert.hpp"
 
+#include "Engine/Trace.hpp"
+
 void Scene::Draw() const
 {
 }
@@ -14,8 +16,15 @@ void Scene::OnExit()
 {
 }
 
+bool Scene::IsIdle() const
+{
+	return true;
+}
+
 void SceneManager::Update(const float deltaT)
 {
+	TRACE_SCOPE("SceneManager::Update");
+
 	if (m_currentScene)
 	{
 		m_currentScene->Update(deltaT);
@@ -24,6 +33,8 @@ void SceneManager::Update(const float deltaT)
 
 void SceneManager::Draw()
 {
+	TRACE_SCOPE("SceneManager::Draw");
+
 	if (m_currentScene)
 	{
 		m_currentScene->Draw();
@@ -32,6 +43,13 @@ void SceneManager::Draw()
 	CheckForChange();
 }
 
+bool SceneManager::IsIdle()
+{
+	std::unique_lock lock(m_mutex);
+
+	return !m_changeScene && (!m_currentScene || m_currentScene->IsIdle());
+}
+
 void SceneManager::ClearScenes()
 {
 	std::unique_lock lock(m_mutex);
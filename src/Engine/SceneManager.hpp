@@ -56,6 +56,15 @@ public:
 	 * Default implementation does nothing.
 	 */
 	virtual void OnExit();
+
+	/**
+	 * @brief Returns true if nothing the scene draws changes over time
+	 *
+	 * Used by Engine idle throttling. Scenes that draw anything animated or read
+	 * input outside InputSystem bindings should return false while they do.
+	 * Default implementation returns true.
+	 */
+	virtual bool IsIdle() const;
 };
 
 /**
@@ -170,6 +179,11 @@ private:
 	 */
 	void CheckForChange();
 
+	/**
+	 * @brief Returns true if no scene transition is pending and the current scene is idle
+	 */
+	bool IsIdle();
+
 	Scene* m_currentScene = nullptr;
 
 	bool m_changeScene = false;
@@ -0,0 +1,212 @@
+#include "Snapshot.hpp"
+
+#include "Log/Logger.hpp"
+
+#include <fstream>
+
+// Stream buffer size used when writing or reading files
+static constexpr u64 FILE_BUFFER_SIZE = 1 << 20;
+
+Snapshot::Snapshot(Registry& registry) :
+m_registry(registry)
+{
+}
+
+bool Snapshot::Save(std::ostream& stream)
+{
+	return Write(stream, Kind::FULL);
+}
+
+bool Snapshot::Save(const std::string& path)
+{
+	std::vector<char> buffer(FILE_BUFFER_SIZE);
+
+	std::ofstream file;
+	file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	file.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!file)
+	{
+		Logger::Write<LogLevel::ERROR>("Failed to open snapshot file ", path);
+		return false;
+	}
+
+	return Save(file);
+}
+
+bool Snapshot::SaveDelta(std::ostream& stream)
+{
+	return Write(stream, Kind::DELTA);
+}
+
+bool Snapshot::SaveDelta(const std::string& path)
+{
+	std::vector<char> buffer(FILE_BUFFER_SIZE);
+
+	std::ofstream file;
+	file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	file.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!file)
+	{
+		Logger::Write<LogLevel::ERROR>("Failed to open snapshot file ", path);
+		return false;
+	}
+
+	return SaveDelta(file);
+}
+
+bool Snapshot::Load(std::istream& stream)
+{
+	u32 magic = 0;
+	u16 version = 0;
+	Kind kind = Kind::FULL;
+	u64 tick = 0;
+	u32 poolCount = 0;
+
+	if (!ReadValue(stream, magic) || !ReadValue(stream, version) || !ReadValue(stream, kind) ||
+		!ReadValue(stream, tick) || !ReadValue(stream, poolCount))
+	{
+		Logger::Write<LogLevel::ERROR>("Snapshot header is truncated");
+		return false;
+	}
+
+	if (magic != MAGIC || version != VERSION)
+	{
+		Logger::Write<LogLevel::ERROR>("Snapshot has an unknown format or version ", version);
+		return false;
+	}
+
+	for (u32 i = 0; i < poolCount; ++i)
+	{
+		u32 id = 0;
+		if (!ReadValue(stream, id))
+		{
+			Logger::Write<LogLevel::ERROR>("Snapshot pool header is truncated");
+			return false;
+		}
+
+		auto it = std::find_if(m_pools.begin(), m_pools.end(), [id](const Pool& pool)
+		{
+			return pool.id == id;
+		});
+
+		if (it == m_pools.end())
+		{
+			Logger::Write<LogLevel::ERROR>("Snapshot contains unknown pool ", id);
+			return false;
+		}
+
+		if (!it->load(m_registry, stream, kind, m_entityMap))
+		{
+			Logger::Write<LogLevel::ERROR>("Snapshot pool ", id, " is malformed");
+			return false;
+		}
+	}
+
+	// What was just loaded should not show up in the next delta
+	m_lastTick = m_registry.AdvanceTick();
+
+	return true;
+}
+
+bool Snapshot::Load(const std::string& path)
+{
+	std::vector<char> buffer(FILE_BUFFER_SIZE);
+
+	std::ifstream file;
+	file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+	file.open(path, std::ios::binary);
+
+	if (!file)
+	{
+		Logger::Write<LogLevel::ERROR>("Failed to open snapshot file ", path);
+		return false;
+	}
+
+	return Load(file);
+}
+
+bool Snapshot::Write(std::ostream& stream, Kind kind)
+{
+	const u64 sinceTick = m_lastTick;
+
+	// Change history older than this may already be trimmed, so a delta could silently miss changes
+	if (kind == Kind::DELTA && sinceTick + 1 < m_registry.GetOldestTrackedTick())
+	{
+		Logger::Write<LogLevel::WARN>("Snapshot delta reaches past the kept change history, saving in full");
+		kind = Kind::FULL;
+	}
+
+	WriteValue(stream, MAGIC);
+	WriteValue(stream, VERSION);
+	WriteValue(stream, kind);
+	WriteValue(stream, m_registry.GetTick());
+	WriteValue(stream, static_cast<u32>(m_pools.size()));
+
+	for (const Pool& pool : m_pools)
+	{
+		WriteValue(stream, pool.id);
+
+		if (!pool.save(m_registry, stream, kind, sinceTick))
+		{
+			Logger::Write<LogLevel::ERROR>("Failed to write snapshot pool ", pool.id);
+			return false;
+		}
+	}
+
+	stream.flush();
+
+	if (!stream)
+	{
+		Logger::Write<LogLevel::ERROR>("Failed to write snapshot");
+		return false;
+	}
+
+	m_lastTick = m_registry.AdvanceTick();
+
+	return true;
+}
+
+void Snapshot::WriteEntities(std::ostream& stream, const Entity* entities, const u64 count)
+{
+	WriteValue(stream, static_cast<u32>(count));
+
+	if (count)
+	{
+		stream.write(reinterpret_cast<const char*>(entities), count * sizeof(Entity));
+	}
+}
+
+bool Snapshot::ReadEntities(std::istream& stream, std::vector<Entity>& entities)
+{
+	u32 count = 0;
+	if (!ReadValue(stream, count))
+	{
+		return false;
+	}
+
+	entities.resize(count);
+
+	return count == 0 || static_cast<bool>(stream.read(reinterpret_cast<char*>(entities.data()), count * sizeof(Entity)));
+}
+
+Entity Snapshot::ResolveEntity(Registry& registry, const Entity saved, EntityMap& entityMap)
+{
+	auto it = entityMap.find(saved);
+	if (it != entityMap.end() && registry.EntityValid(it->second))
+	{
+		return it->second;
+	}
+
+	Entity entity = saved;
+	if (!registry.EntityValid(saved))
+	{
+		// Uses the saved identifier if it is free, otherwise a new one
+		entity = registry.GetRegistry().create(saved);
+	}
+
+	entityMap.insert_or_assign(saved, entity);
+
+	return entity;
+}
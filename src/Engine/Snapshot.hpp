@@ -0,0 +1,397 @@
+#pragma once
+
+#include "Assert.hpp"
+#include "Types.hpp"
+
+#include "Engine/Registry.hpp"
+#include "entt/entt.hpp"
+
+#include "cereal/MyCereal.h"
+#include <cereal/archives/binary.hpp>
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file Snapshot.hpp
+ * @brief Binary registry save and load.
+ */
+
+/**
+ * @brief Saves and restores selected component pools of a Registry
+ *
+ * Pools are registered once with AddPool under a stable ID. Saving writes a small
+ * versioned header followed by one contiguous block per pool: the entity list and
+ * then the components. Trivially copyable components are written as raw memory,
+ * page by page; everything else goes through its cereal serialize function. Empty
+ * tag components only store their entities.
+ *
+ * Data is written straight to the stream, so saving to a file never holds the
+ * whole snapshot in memory.
+ *
+ * SaveDelta only writes entities whose components were added or changed since the
+ * previous save, plus the components removed since then. Registered pools have
+ * change tracking enabled for this. Loading accepts both full and delta snapshots.
+ * Entities that no longer exist in the target registry are recreated, under the
+ * same identifier when it is free.
+ *
+ * Usage:
+ * @code
+ * Snapshot snapshot(REGISTRY);
+ * snapshot.AddPool<Component::Transform>(1).AddPool<Health>(2);
+ *
+ * snapshot.Save("world.snap");
+ * ...
+ * snapshot.SaveDelta("world.delta");
+ * @endcode
+ */
+class Snapshot
+{
+public:
+
+	/**
+	 * @brief Creates a snapshot helper for a registry
+	 *
+	 * @param registry Registry to save from and load into
+	 */
+	Snapshot(Registry& registry);
+
+	/**
+	 * @brief Includes a component pool in the snapshots
+	 *
+	 * Enables change tracking for the component so deltas can be produced.
+	 * Asserts if the ID is already in use.
+	 *
+	 * @tparam Component Component type; must be trivially copyable or cereal serializable
+	 * @param id Stable identifier written to the file; must not change between versions
+	 * @return Reference to this snapshot for chaining
+	 */
+	template <typename Component>
+	Snapshot& AddPool(const u32 id)
+	{
+		for (const Pool& pool : m_pools)
+		{
+			Assert(pool.id != id, "Snapshot pool id ", id, " is already in use");
+		}
+
+		m_registry.EnableChangeTracking<Component>();
+
+		m_pools.push_back(Pool{.id = id, .save = &Snapshot::SavePool<Component>, .load = &Snapshot::LoadPool<Component>});
+
+		return *this;
+	}
+
+	/**
+	 * @brief Writes every registered pool to a stream
+	 *
+	 * @param stream Binary output stream
+	 * @return True if everything was written
+	 */
+	bool Save(std::ostream& stream);
+
+	/**
+	 * @brief Writes every registered pool to a file
+	 *
+	 * @param path File to create or overwrite
+	 * @return True if the file was written
+	 */
+	bool Save(const std::string& path);
+
+	/**
+	 * @brief Writes only what changed since the previous Save or SaveDelta to a stream
+	 *
+	 * Falls back to a full save, with a warning, if the previous save is older than
+	 * the registry's change history (see Registry::SetChangeHistory).
+	 *
+	 * @param stream Binary output stream
+	 * @return True if everything was written
+	 */
+	bool SaveDelta(std::ostream& stream);
+
+	/**
+	 * @brief Writes only what changed since the previous Save or SaveDelta to a file
+	 *
+	 * @param path File to create or overwrite
+	 * @return True if the file was written
+	 */
+	bool SaveDelta(const std::string& path);
+
+	/**
+	 * @brief Reads a full or delta snapshot from a stream into the registry
+	 *
+	 * A full snapshot replaces the contents of every pool it contains. A delta
+	 * snapshot adds or replaces the saved components and removes the removed ones.
+	 *
+	 * @param stream Binary input stream
+	 * @return False if the data is malformed, from another version, or contains an unknown pool
+	 */
+	bool Load(std::istream& stream);
+
+	/**
+	 * @brief Reads a full or delta snapshot from a file into the registry
+	 *
+	 * @param path File to read
+	 * @return False if the file can't be read or Load fails
+	 */
+	bool Load(const std::string& path);
+
+	/// Identifies snapshot files
+	static constexpr u32 MAGIC = 0x504E5345; // "ESNP"
+
+	/// Bumped whenever the layout changes
+	static constexpr u16 VERSION = 1;
+
+private:
+
+	enum class Kind : u8
+	{
+		FULL,
+		DELTA
+	};
+
+	enum class Encoding : u8
+	{
+		RAW,
+		CEREAL
+	};
+
+	using EntityMap = std::unordered_map<Entity, Entity>;
+
+	using SaveFunction = bool (*)(Registry& registry, std::ostream& stream, const Kind kind, const u64 sinceTick);
+	using LoadFunction = bool (*)(Registry& registry, std::istream& stream, const Kind kind, EntityMap& entityMap);
+
+	struct Pool
+	{
+		u32 id = 0;
+		SaveFunction save = nullptr;
+		LoadFunction load = nullptr;
+	};
+
+	// Number of components staged before a raw delta write
+	static constexpr u64 STAGING_SIZE = 1024;
+
+	bool Write(std::ostream& stream, Kind kind);
+
+	template <typename T>
+	static void WriteValue(std::ostream& stream, const T& value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template <typename T>
+	static bool ReadValue(std::istream& stream, T& value)
+	{
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	static void WriteEntities(std::ostream& stream, const Entity* entities, const u64 count);
+	static bool ReadEntities(std::istream& stream, std::vector<Entity>& entities);
+
+	static Entity ResolveEntity(Registry& registry, const Entity saved, EntityMap& entityMap);
+
+	template <typename Component>
+	static bool SavePool(Registry& registry, std::ostream& stream, const Kind kind, const u64 sinceTick)
+	{
+		auto& storage = registry.GetRegistry().storage<Component>();
+
+		const Encoding encoding = std::is_trivially_copyable_v<Component> ? Encoding::RAW : Encoding::CEREAL;
+		WriteValue(stream, encoding);
+		WriteValue(stream, static_cast<u32>(sizeof(Component)));
+
+		std::vector<Entity> entities;
+
+		if (kind == Kind::DELTA)
+		{
+			const std::vector<Entity> removed = registry.GetRemovedView<Component>(sinceTick);
+			WriteEntities(stream, removed.data(), removed.size());
+
+			entities = registry.GetChangedView<Component>(sinceTick);
+			WriteEntities(stream, entities.data(), entities.size());
+		}
+
+		else
+		{
+			WriteEntities(stream, nullptr, 0);
+			WriteEntities(stream, storage.data(), storage.size());
+		}
+
+		if constexpr (std::is_empty_v<Component>)
+		{
+			// Tags have no data, the entity lists say everything
+		}
+
+		else if constexpr (std::is_trivially_copyable_v<Component>)
+		{
+			if (kind == Kind::FULL)
+			{
+				// Components are stored in pages matching the packed entity order
+				constexpr u64 pageSize = entt::component_traits<Component>::page_size;
+
+				for (u64 first = 0; first < storage.size(); first += pageSize)
+				{
+					const u64 count = std::min<u64>(pageSize, storage.size() - first);
+					stream.write(reinterpret_cast<const char*>(storage.raw()[first / pageSize]), count * sizeof(Component));
+				}
+			}
+
+			else
+			{
+				std::vector<Component> staging;
+				staging.reserve(std::min<u64>(STAGING_SIZE, entities.size()));
+
+				for (const Entity entity : entities)
+				{
+					staging.push_back(storage.get(entity));
+
+					if (staging.size() == STAGING_SIZE)
+					{
+						stream.write(reinterpret_cast<const char*>(staging.data()), staging.size() * sizeof(Component));
+						staging.clear();
+					}
+				}
+
+				stream.write(reinterpret_cast<const char*>(staging.data()), staging.size() * sizeof(Component));
+			}
+		}
+
+		else
+		{
+			cereal::BinaryOutputArchive archive(stream);
+
+			if (kind == Kind::FULL)
+			{
+				for (u64 i = 0; i < storage.size(); ++i)
+				{
+					archive(storage.get(storage.data()[i]));
+				}
+			}
+
+			else
+			{
+				for (const Entity entity : entities)
+				{
+					archive(storage.get(entity));
+				}
+			}
+		}
+
+		return static_cast<bool>(stream);
+	}
+
+	template <typename Component>
+	static bool LoadPool(Registry& registry, std::istream& stream, const Kind kind, EntityMap& entityMap)
+	{
+		Encoding encoding = Encoding::RAW;
+		u32 componentSize = 0;
+
+		if (!ReadValue(stream, encoding) || !ReadValue(stream, componentSize))
+		{
+			return false;
+		}
+
+		const Encoding expected = std::is_trivially_copyable_v<Component> ? Encoding::RAW : Encoding::CEREAL;
+		if (encoding != expected || componentSize != sizeof(Component))
+		{
+			return false;
+		}
+
+		std::vector<Entity> removed;
+		std::vector<Entity> entities;
+
+		if (!ReadEntities(stream, removed) || !ReadEntities(stream, entities))
+		{
+			return false;
+		}
+
+		// Tags have no data to read, only the entities are used below
+		std::vector<Component> components(std::is_empty_v<Component> ? 0 : entities.size());
+
+		if constexpr (std::is_empty_v<Component>)
+		{
+		}
+
+		else if constexpr (std::is_trivially_copyable_v<Component>)
+		{
+			if (!stream.read(reinterpret_cast<char*>(components.data()), components.size() * sizeof(Component)))
+			{
+				return false;
+			}
+		}
+
+		else
+		{
+			cereal::BinaryInputArchive archive(stream);
+
+			for (Component& component : components)
+			{
+				archive(component);
+			}
+		}
+
+		if (kind == Kind::FULL)
+		{
+			registry.ClearComponents<Component>();
+		}
+
+		for (const Entity saved : removed)
+		{
+			auto it = entityMap.find(saved);
+			const Entity entity = it != entityMap.end() ? it->second : saved;
+
+			// Nothing to remove from an entity that was never loaded
+			if (registry.EntityValid(entity))
+			{
+				registry.Remove<Component>(entity);
+			}
+		}
+
+		for (Entity& entity : entities)
+		{
+			entity = ResolveEntity(registry, entity, entityMap);
+		}
+
+		if constexpr (std::is_empty_v<Component>)
+		{
+			auto& storage = registry.GetRegistry().storage<Component>();
+
+			for (const Entity entity : entities)
+			{
+				if (!storage.contains(entity))
+				{
+					storage.emplace(entity);
+				}
+			}
+		}
+
+		else if (kind == Kind::FULL)
+		{
+			// Pool is empty, so everything can be range inserted at once
+			registry.GetRegistry().storage<Component>().insert(entities.begin(), entities.end(), components.begin());
+		}
+
+		else
+		{
+			for (u64 i = 0; i < entities.size(); ++i)
+			{
+				registry.EmplaceOrReplace<Component>(entities[i], std::move(components[i]));
+			}
+		}
+
+		return true;
+	}
+
+	Registry& m_registry;
+
+	std::vector<Pool> m_pools;
+
+	u64 m_lastTick = 0;
+
+	// Saved identifier to live entity, kept across loads so deltas reach the entities
+	// earlier loads created under a different identifier
+	EntityMap m_entityMap;
+};
@@ -0,0 +1,256 @@
+#include "SpatialGrid.hpp"
+
+#include "Assert.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(const float cellSize) :
+m_cellSize(cellSize)
+{
+	Assert(cellSize > 0, "Spatial grid cells must have a size");
+}
+
+void SpatialGrid::Update(const Entity entity, const Rectangle& bounds)
+{
+	if (HasNan(bounds))
+	{
+		Remove(entity);
+		return;
+	}
+
+	const CellRange cells = ToCells(bounds);
+	const u32 index = entt::to_entity(entity);
+
+	if (index >= m_records.size())
+	{
+		m_records.resize(std::bit_ceil(index + 1));
+	}
+
+	Record& record = m_records[index];
+
+	if (record.entity == entity && record.cells == cells)
+	{
+		return;
+	}
+
+	// Also drops a destroyed entity whose index was recycled
+	if (record.entity != entt::null)
+	{
+		Erase(record.entity, record.cells);
+	}
+
+	else
+	{
+		m_size++;
+	}
+
+	Insert(entity, cells);
+
+	record = {entity, cells};
+}
+
+void SpatialGrid::Remove(const Entity entity)
+{
+	if (!Contains(entity))
+	{
+		return;
+	}
+
+	Record& record = m_records[entt::to_entity(entity)];
+
+	Erase(entity, record.cells);
+
+	record = {};
+	m_size--;
+}
+
+bool SpatialGrid::Contains(const Entity entity) const
+{
+	const u32 index = entt::to_entity(entity);
+
+	return index < m_records.size() && m_records[index].entity == entity;
+}
+
+void SpatialGrid::Query(const Rectangle& area, std::vector<Entity>& entities) const
+{
+	const CellRange range = ToCells(area);
+
+	auto visit = [&range, &entities](const i32 x, const i32 y, const std::vector<Entry>& cell)
+	{
+		for (const Entry& entry : cell)
+		{
+			if (x == std::max(entry.minX, range.minX) && y == std::max(entry.minY, range.minY))
+			{
+				entities.push_back(entry.entity);
+			}
+		}
+	};
+
+	if (range.maxX < range.minX || range.maxY < range.minY)
+	{
+		return;
+	}
+
+	for (const Entity entity : m_oversized)
+	{
+		const CellRange& cells = m_records[entt::to_entity(entity)].cells;
+
+		if (cells.minX <= range.maxX && cells.maxX >= range.minX && cells.minY <= range.maxY &&
+			cells.maxY >= range.minY)
+		{
+			entities.push_back(entity);
+		}
+	}
+
+	const u64 width = static_cast<u64>(range.maxX - range.minX) + 1;
+	const u64 height = static_cast<u64>(range.maxY - range.minY) + 1;
+
+	// Zoomed far out, walking the occupied cells is cheaper than walking the area
+	if (width * height > m_cells.size())
+	{
+		for (const auto& [key, cell] : m_cells)
+		{
+			const i32 x = static_cast<i32>(static_cast<u32>(key >> 32));
+			const i32 y = static_cast<i32>(static_cast<u32>(key));
+
+			if (x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY)
+			{
+				visit(x, y, cell);
+			}
+		}
+
+		return;
+	}
+
+	for (i32 y = range.minY; y <= range.maxY; y++)
+	{
+		for (i32 x = range.minX; x <= range.maxX; x++)
+		{
+			auto it = m_cells.find(CellKey(x, y));
+			if (it != m_cells.end())
+			{
+				visit(x, y, it->second);
+			}
+		}
+	}
+}
+
+void SpatialGrid::Clear()
+{
+	m_cells.clear();
+	m_records.clear();
+	m_oversized.clear();
+	m_size = 0;
+}
+
+u32 SpatialGrid::GetSize() const
+{
+	return m_size;
+}
+
+float SpatialGrid::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+SpatialGrid::CellRange SpatialGrid::ToCells(const Rectangle& rectangle) const
+{
+	// Keeps absurd coordinates from overflowing the cell indices
+	static constexpr float LIMIT = 1 << 29;
+
+	// No cells, NaN can't be converted to one
+	if (HasNan(rectangle))
+	{
+		return {};
+	}
+
+	auto cell = [this](const float coordinate)
+	{
+		return static_cast<i32>(std::clamp(std::floor(coordinate / m_cellSize), -LIMIT, LIMIT));
+	};
+
+	return {cell(rectangle.x), cell(rectangle.y), cell(rectangle.x + rectangle.width),
+	cell(rectangle.y + rectangle.height)};
+}
+
+u64 SpatialGrid::CellKey(const i32 x, const i32 y)
+{
+	return (static_cast<u64>(static_cast<u32>(x)) << 32) | static_cast<u32>(y);
+}
+
+bool SpatialGrid::HasNan(const Rectangle& rectangle)
+{
+	return std::isnan(rectangle.x) || std::isnan(rectangle.y) || std::isnan(rectangle.width) ||
+		   std::isnan(rectangle.height);
+}
+
+bool SpatialGrid::IsOversized(const CellRange& cells)
+{
+	if (cells.maxX < cells.minX || cells.maxY < cells.minY)
+	{
+		return false;
+	}
+
+	const u64 width = static_cast<u64>(cells.maxX - cells.minX) + 1;
+	const u64 height = static_cast<u64>(cells.maxY - cells.minY) + 1;
+
+	return width * height > MAX_CELLS;
+}
+
+void SpatialGrid::Insert(const Entity entity, const CellRange& cells)
+{
+	if (IsOversized(cells))
+	{
+		m_oversized.push_back(entity);
+		return;
+	}
+
+	for (i32 y = cells.minY; y <= cells.maxY; y++)
+	{
+		for (i32 x = cells.minX; x <= cells.maxX; x++)
+		{
+			m_cells[CellKey(x, y)].push_back({entity, cells.minX, cells.minY});
+		}
+	}
+}
+
+void SpatialGrid::Erase(const Entity entity, const CellRange& cells)
+{
+	if (IsOversized(cells))
+	{
+		auto it = std::find(m_oversized.begin(), m_oversized.end(), entity);
+		Assert(it != m_oversized.end(), "Spatial grid is missing an oversized entity");
+
+		*it = m_oversized.back();
+		m_oversized.pop_back();
+
+		return;
+	}
+
+	for (i32 y = cells.minY; y <= cells.maxY; y++)
+	{
+		for (i32 x = cells.minX; x <= cells.maxX; x++)
+		{
+			auto it = m_cells.find(CellKey(x, y));
+			Assert(it != m_cells.end(), "Spatial grid cell is missing an entity");
+
+			std::vector<Entry>& cell = it->second;
+
+			auto entry = std::find_if(cell.begin(), cell.end(), [entity](const Entry& entry)
+			{
+				return entry.entity == entity;
+			});
+
+			*entry = cell.back();
+			cell.pop_back();
+
+			// Only occupied cells are kept, so far out queries can walk them instead
+			if (cell.empty())
+			{
+				m_cells.erase(it);
+			}
+		}
+	}
+}
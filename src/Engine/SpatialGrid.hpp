@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include "Engine/Registry.hpp"
+#include "entt/entt.hpp"
+#include "raylib.h"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file SpatialGrid.hpp
+ * @brief Uniform grid broadphase for entity bounds.
+ */
+
+/**
+ * @brief Buckets entity bounding rectangles into square cells for fast area queries
+ *
+ * Only occupied cells are stored, so the world has no fixed extent. An entity
+ * overlapping several cells is stored in each of them and still reported once
+ * per query. Update is cheap when the entity stays within the same cells, so
+ * owners re-submit bounds whenever an entity moves or resizes instead of
+ * rebuilding the grid.
+ *
+ * Queries return candidates whose stored bounds' cells overlap the area. Owners
+ * should store conservative bounds and run their exact test on the candidates.
+ *
+ * Entities covering more than MAX_CELLS cells are kept in a separate list that
+ * every query checks instead, so huge bounds cost neither memory nor time per
+ * cell. Bounds or areas with NaN coordinates are rejected.
+ */
+class SpatialGrid
+{
+public:
+
+	/**
+	 * @brief Creates an empty grid
+	 *
+	 * Cells around the size of a typical entity, or a fraction of the typical
+	 * query area, work best.
+	 *
+	 * @param cellSize Width and height of a cell in world units
+	 */
+	explicit SpatialGrid(const float cellSize = 256);
+
+	/// Cells an entity may cover before it goes in the oversized list
+	static constexpr u64 MAX_CELLS = 1024;
+
+	/**
+	 * @brief Inserts an entity or moves it to new bounds
+	 *
+	 * Bounds with a NaN coordinate remove the entity instead.
+	 *
+	 * @param entity Entity to store
+	 * @param bounds World space bounding rectangle
+	 */
+	void Update(const Entity entity, const Rectangle& bounds);
+
+	/**
+	 * @brief Removes an entity
+	 *
+	 * Does nothing if the entity is not in the grid.
+	 *
+	 * @param entity Entity to remove
+	 */
+	void Remove(const Entity entity);
+
+	/**
+	 * @brief Returns true if the entity is in the grid
+	 */
+	bool Contains(const Entity entity) const;
+
+	/**
+	 * @brief Appends every entity whose cells overlap an area
+	 *
+	 * Each entity is appended once, in no particular order.
+	 *
+	 * @param area     World space rectangle to query
+	 * @param entities Vector to append to
+	 */
+	void Query(const Rectangle& area, std::vector<Entity>& entities) const;
+
+	/**
+	 * @brief Removes every entity
+	 */
+	void Clear();
+
+	/**
+	 * @brief Returns the number of entities in the grid
+	 */
+	u32 GetSize() const;
+
+	/**
+	 * @brief Returns the width and height of a cell
+	 */
+	float GetCellSize() const;
+
+private:
+
+	struct CellRange
+	{
+		i32 minX = 0;
+		i32 minY = 0;
+		i32 maxX = -1;
+		i32 maxY = -1;
+
+		bool operator==(const CellRange&) const = default;
+	};
+
+	struct Entry
+	{
+		Entity entity;
+
+		// First cell of the entity, queries report it from the first overlapping cell only
+		i32 minX;
+		i32 minY;
+	};
+
+	struct Record
+	{
+		Entity entity = entt::null;
+		CellRange cells;
+	};
+
+	CellRange ToCells(const Rectangle& rectangle) const;
+
+	static u64 CellKey(const i32 x, const i32 y);
+
+	static bool HasNan(const Rectangle& rectangle);
+	static bool IsOversized(const CellRange& cells);
+
+	void Insert(const Entity entity, const CellRange& cells);
+	void Erase(const Entity entity, const CellRange& cells);
+
+	float m_cellSize;
+
+	std::unordered_map<u64, std::vector<Entry>> m_cells;
+
+	// Indexed by entity index
+	std::vector<Record> m_records;
+
+	// Entities covering more than MAX_CELLS cells, stored in no cell
+	std::vector<Entity> m_oversized;
+
+	u32 m_size = 0;
+};
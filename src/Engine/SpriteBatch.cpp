@@ -0,0 +1,218 @@
+#include "SpriteBatch.hpp"
+
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+void SpriteBatch::Draw(const Texture2D& texture, Rectangle source, const Rectangle& dest, const Vector2 origin,
+const float rotation, const Color color)
+{
+	// Nothing to sample, and the texture size divides the coordinates below
+	if (!IsTextureValid(texture))
+	{
+		return;
+	}
+
+	if (!m_vertexBuffer)
+	{
+		Load();
+	}
+
+	if (texture.id != m_texture || m_quadCount == MAX_QUADS)
+	{
+		Flush();
+
+		m_texture = texture.id;
+	}
+
+	// Same flipping rules as DrawTexturePro
+	bool flipX = false;
+	if (source.width < 0)
+	{
+		flipX = true;
+		source.width *= -1;
+	}
+
+	if (source.height < 0)
+	{
+		source.y -= source.height;
+	}
+
+	const float width = static_cast<float>(texture.width);
+	const float height = static_cast<float>(texture.height);
+
+	float left = source.x / width;
+	float right = (source.x + source.width) / width;
+	const float top = source.y / height;
+	const float bottom = (source.y + source.height) / height;
+
+	if (flipX)
+	{
+		std::swap(left, right);
+	}
+
+	float cosR = 1;
+	float sinR = 0;
+
+	if (rotation != 0)
+	{
+		cosR = std::cos(rotation * DEG2RAD);
+		sinR = std::sin(rotation * DEG2RAD);
+	}
+
+	const float dx = -origin.x;
+	const float dy = -origin.y;
+
+	auto corner = [&dest, cosR, sinR](const float x, const float y) -> Vector2
+	{
+		return {dest.x + (x * cosR) - (y * sinR), dest.y + (x * sinR) + (y * cosR)};
+	};
+
+	const Vector2 topLeft = corner(dx, dy);
+	const Vector2 bottomLeft = corner(dx, dy + dest.height);
+	const Vector2 bottomRight = corner(dx + dest.width, dy + dest.height);
+	const Vector2 topRight = corner(dx + dest.width, dy);
+
+	Vertex* vertex = &m_vertices[static_cast<u64>(m_quadCount) * 4];
+
+	vertex[0] = {topLeft.x, topLeft.y, left, top, color.r, color.g, color.b, color.a};
+	vertex[1] = {bottomLeft.x, bottomLeft.y, left, bottom, color.r, color.g, color.b, color.a};
+	vertex[2] = {bottomRight.x, bottomRight.y, right, bottom, color.r, color.g, color.b, color.a};
+	vertex[3] = {topRight.x, topRight.y, right, top, color.r, color.g, color.b, color.a};
+
+	m_quadCount++;
+	m_quads++;
+}
+
+void SpriteBatch::Flush()
+{
+	if (!m_quadCount)
+	{
+		return;
+	}
+
+	// Whatever raylib batched before these quads has to be drawn first
+	rlDrawRenderBatchActive();
+
+	rlUpdateVertexBuffer(m_vertexBuffer, m_vertices.data(), m_quadCount * 4 * sizeof(Vertex), 0);
+
+	const i32* locations = rlGetShaderLocsDefault();
+
+	rlEnableShader(rlGetShaderIdDefault());
+
+	const Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+	rlSetUniformMatrix(locations[RL_SHADER_LOC_MATRIX_MVP], mvp);
+
+	const float white[4] = {1, 1, 1, 1};
+	rlSetUniform(locations[RL_SHADER_LOC_COLOR_DIFFUSE], white, RL_SHADER_UNIFORM_VEC4, 1);
+
+	const i32 textureSlot = 0;
+	rlSetUniform(locations[RL_SHADER_LOC_MAP_DIFFUSE], &textureSlot, RL_SHADER_UNIFORM_INT, 1);
+
+	rlActiveTextureSlot(0);
+	rlEnableTexture(m_texture);
+
+	// Without vertex array support the buffers have to be bound by hand
+	if (!rlEnableVertexArray(m_vertexArray))
+	{
+		rlEnableVertexBuffer(m_vertexBuffer);
+		BindAttributes();
+		rlEnableVertexBufferElement(m_indexBuffer);
+	}
+
+	rlDrawVertexArrayElements(0, m_quadCount * 6, nullptr);
+
+	rlDisableVertexArray();
+	rlDisableVertexBuffer();
+	rlDisableVertexBufferElement();
+	rlDisableTexture();
+	rlDisableShader();
+
+	m_quadCount = 0;
+	m_drawCalls++;
+}
+
+void SpriteBatch::Unload()
+{
+	if (!m_vertexBuffer)
+	{
+		return;
+	}
+
+	rlUnloadVertexArray(m_vertexArray);
+	rlUnloadVertexBuffer(m_vertexBuffer);
+	rlUnloadVertexBuffer(m_indexBuffer);
+
+	m_vertexArray = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+
+	m_vertices.clear();
+	m_vertices.shrink_to_fit();
+	m_quadCount = 0;
+}
+
+u32 SpriteBatch::GetDrawCalls() const
+{
+	return m_drawCalls;
+}
+
+u32 SpriteBatch::GetQuads() const
+{
+	return m_quads;
+}
+
+void SpriteBatch::ResetStats()
+{
+	m_drawCalls = 0;
+	m_quads = 0;
+}
+
+void SpriteBatch::Load()
+{
+	m_vertices.resize(static_cast<u64>(MAX_QUADS) * 4);
+
+	std::vector<u16> indices(static_cast<u64>(MAX_QUADS) * 6);
+	for (u32 quad = 0; quad < MAX_QUADS; quad++)
+	{
+		const u16 first = quad * 4;
+		u16* index = &indices[static_cast<u64>(quad) * 6];
+
+		index[0] = first;
+		index[1] = first + 1;
+		index[2] = first + 2;
+		index[3] = first;
+		index[4] = first + 2;
+		index[5] = first + 3;
+	}
+
+	m_vertexArray = rlLoadVertexArray();
+	rlEnableVertexArray(m_vertexArray);
+
+	m_vertexBuffer = rlLoadVertexBuffer(nullptr, m_vertices.size() * sizeof(Vertex), true);
+	BindAttributes();
+
+	m_indexBuffer = rlLoadVertexBufferElement(indices.data(), indices.size() * sizeof(u16), false);
+
+	rlDisableVertexArray();
+}
+
+void SpriteBatch::BindAttributes() const
+{
+	const i32* locations = rlGetShaderLocsDefault();
+
+	rlSetVertexAttribute(locations[RL_SHADER_LOC_VERTEX_POSITION], 2, RL_FLOAT, false, sizeof(Vertex),
+	offsetof(Vertex, x));
+	rlEnableVertexAttribute(locations[RL_SHADER_LOC_VERTEX_POSITION]);
+
+	rlSetVertexAttribute(locations[RL_SHADER_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, false, sizeof(Vertex),
+	offsetof(Vertex, u));
+	rlEnableVertexAttribute(locations[RL_SHADER_LOC_VERTEX_TEXCOORD01]);
+
+	rlSetVertexAttribute(locations[RL_SHADER_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, true, sizeof(Vertex),
+	offsetof(Vertex, r));
+	rlEnableVertexAttribute(locations[RL_SHADER_LOC_VERTEX_COLOR]);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include "raylib.h"
+
+#include <vector>
+
+/**
+ * @file SpriteBatch.hpp
+ * @brief Batched textured quad submission.
+ */
+
+/**
+ * @brief Draws textured quads in as few draw calls as possible
+ *
+ * Quads are transformed on the CPU and written into a persistent vertex buffer
+ * owned by the batch, bypassing the per vertex immediate mode calls of
+ * DrawTexturePro. Consecutive quads sharing a texture are drawn with a single
+ * call, so callers should submit them sorted by texture.
+ *
+ * Uses the raylib default shader and the current rlgl modelview and projection,
+ * so it works inside BeginMode2D and BeginTextureMode. Anything drawn with raylib
+ * between quads is flushed first, keeping the draw order.
+ *
+ * GPU buffers are created on first use. Unload must be called while the GL
+ * context is still alive.
+ */
+class SpriteBatch : public NonCopyable<>
+{
+public:
+
+	/**
+	 * @brief Adds a quad, placed exactly like DrawTexturePro would
+	 *
+	 * Quads with an invalid texture are skipped.
+	 *
+	 * @param texture  Texture to sample
+	 * @param source   Part of the texture, negative width or height flip it
+	 * @param dest     Position of the origin and size of the quad
+	 * @param origin   Point of the quad placed at dest and rotated around
+	 * @param rotation Rotation in degrees
+	 * @param color    Tint
+	 */
+	void Draw(const Texture2D& texture, Rectangle source, const Rectangle& dest, const Vector2 origin,
+	const float rotation, const Color color);
+
+	/**
+	 * @brief Draws every quad added since the last flush
+	 *
+	 * Must be called before the modelview or projection changes, such as before
+	 * EndMode2D, and at the end of drawing.
+	 */
+	void Flush();
+
+	/**
+	 * @brief Releases the GPU buffers
+	 */
+	void Unload();
+
+	/**
+	 * @brief Returns the draw calls issued since the last ResetStats
+	 */
+	u32 GetDrawCalls() const;
+
+	/**
+	 * @brief Returns the quads added since the last ResetStats
+	 */
+	u32 GetQuads() const;
+
+	/**
+	 * @brief Restarts the draw call and quad counts
+	 */
+	void ResetStats();
+
+private:
+
+	struct Vertex
+	{
+		float x;
+		float y;
+		float u;
+		float v;
+		u8 r;
+		u8 g;
+		u8 b;
+		u8 a;
+	};
+
+	// Indices are 16 bit, so 65536 vertices at most
+	static constexpr u32 MAX_QUADS = 16384;
+
+	void Load();
+	void BindAttributes() const;
+
+	std::vector<Vertex> m_vertices;
+	u32 m_quadCount = 0;
+	u32 m_texture = 0;
+
+	u32 m_vertexArray = 0;
+	u32 m_vertexBuffer = 0;
+	u32 m_indexBuffer = 0;
+
+	u32 m_drawCalls = 0;
+	u32 m_quads = 0;
+};
@@ -1,33 +1,482 @@
 #include "SystemManager.hpp"
 
+#include "Engine/Trace.hpp"
+#include "Log/Logger.hpp"
+#include "Timing.hpp"
+
+bool SystemAccess::Conflicts(const SystemAccess& other) const
+{
+	if (exclusive || other.exclusive)
+	{
+		return true;
+	}
+
+	auto intersects = [](const std::vector<u32>& a, const std::vector<u32>& b)
+	{
+		return std::any_of(a.begin(), a.end(), [&b](const u32 type)
+		{
+			return std::find(b.begin(), b.end(), type) != b.end();
+		});
+	};
+
+	return intersects(writes, other.reads) || intersects(writes, other.writes) || intersects(other.writes, reads);
+}
+
+System::~System()
+{
+	for (auto it = m_cleanups.rbegin(); it != m_cleanups.rend(); ++it)
+	{
+		(*it)();
+	}
+}
+
 void System::Draw() const
 {
 }
 
-void SystemManager::Update(const float deltaT)
+void System::Extract([[maybe_unused]] RenderSnapshot& snapshot) const
+{
+}
+
+bool System::IsIdle() const
+{
+	return true;
+}
+
+const SystemAccess& System::GetAccess() const
+{
+	return m_access;
+}
+
+void System::SetAccess(const SystemAccess& access)
+{
+	m_access = access;
+	s_accessGeneration++;
+}
+
+void System::AddCleanup(std::function<void()> cleanup)
 {
+	m_cleanups.push_back(std::move(cleanup));
+}
+
+SystemManager::SystemManager(Registry& registry) :
+m_registry(registry)
+{
+}
+
+#ifdef ENGINE_SYSTEM_PROFILING
+void System::TimingWindow::Add(const double time)
+{
+	samples[next] = time;
+	next = (next + 1) % samples.size();
+	count = std::min<u32>(count + 1, samples.size());
+	calls++;
+}
+
+TimingStats System::TimingWindow::Compute() const
+{
+	TimingStats stats;
+	stats.calls = calls;
+
+	if (!count)
+	{
+		return stats;
+	}
+
+	std::array<float, 256> sorted;
+	std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+	std::sort(sorted.begin(), sorted.begin() + count);
+
+	double sum = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		sum += sorted[i];
+	}
+
+	stats.mean = sum / count;
+	stats.max = sorted[count - 1];
+	stats.p99 = sorted[((count * 99) + 99) / 100 - 1];
+
+	return stats;
+}
+#endif
+
+void SystemManager::Update(const float deltaT, const Threads threads)
+{
+	TRACE_SCOPE("SystemManager::Update");
+
 	std::unique_lock lock(m_mutex);
 
-	for (auto& pair : m_systems)
+	const u32 generation = System::s_accessGeneration;
+	if (m_scheduleDirty || generation != m_accessGeneration)
+	{
+		BuildSchedule();
+
+		m_accessGeneration = generation;
+		m_scheduleDirty = false;
+	}
+
+	const bool runPipeline = threads == Threads::ALL || (threads == Threads::MAIN_THREAD) == m_pipelineMainThread;
+	if (m_pipeline && runPipeline)
 	{
-		pair.second->Update(deltaT);
+		TRACE_SCOPE("SystemPipeline::Update");
+
+		m_pipeline->Update(*this, deltaT);
 	}
+
+	for (const Wave& wave : m_waves)
+	{
+		RunWave(wave, deltaT, threads);
+	}
+
+	if (threads != Threads::MAIN_THREAD)
+	{
+		m_step++;
+	}
+
+	if (threads != Threads::POOLED)
+	{
+		m_mainThreadStep++;
+	}
+
+	// Callbacks may look up systems
+	lock.unlock();
+
+	ReportOverBudget();
 }
 
 void SystemManager::Draw()
 {
+	TRACE_SCOPE("SystemManager::Draw");
+
+	std::unique_lock lock(m_mutex);
+
+	if (m_pipeline)
+	{
+		TRACE_SCOPE("SystemPipeline::Draw");
+
+		m_pipeline->Draw(*this);
+	}
+
+	for (auto& pair : m_systems)
+	{
+		DrawSystem(*pair.second);
+	}
+
+	lock.unlock();
+
+	ReportOverBudget();
+}
+
+void SystemManager::Extract(RenderSnapshot& snapshot)
+{
+	TRACE_SCOPE("SystemManager::Extract");
+
 	std::unique_lock lock(m_mutex);
 
+	if (m_pipeline)
+	{
+		m_pipeline->Extract(snapshot);
+	}
+
 	for (auto& pair : m_systems)
 	{
-		pair.second->Draw();
+		pair.second->Extract(snapshot);
+	}
+}
+
+bool SystemManager::IsIdle()
+{
+	std::unique_lock lock(m_mutex);
+
+	if (m_pipeline && !m_pipeline->IsIdle())
+	{
+		return false;
 	}
+
+	for (const auto& pair : m_systems)
+	{
+		if (!pair.second->IsIdle())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::vector<SystemTimings> SystemManager::GetTimings()
+{
+	std::shared_lock lock(m_mutex);
+
+	std::vector<SystemTimings> timings;
+	timings.reserve(m_pipelineSlots.size() + m_systems.size());
+
+	auto add = [&timings](const System& system, const u32 priority)
+	{
+		SystemTimings& timing = timings.emplace_back();
+		timing.name = system.m_name;
+		timing.priority = priority;
+
+#ifdef ENGINE_SYSTEM_PROFILING
+		timing.update = system.m_updateTiming.Compute();
+		timing.draw = system.m_drawTiming.Compute();
+#endif
+	};
+
+	// The pipeline runs before the dynamic systems
+	for (const auto& [slot, system] : m_pipelineSlots)
+	{
+		add(*system, 0);
+	}
+
+	for (const auto& [priority, system] : m_systems)
+	{
+		add(*system, priority);
+	}
+
+	return timings;
+}
+
+void SystemManager::SetBudgetCallback(
+const std::function<void(const std::string& system, const bool draw, const double time, const double budget)>&
+callback)
+{
+	std::unique_lock lock(m_mutex);
+
+	m_budgetCallback = callback;
 }
 
 void SystemManager::ClearSystems()
 {
 	std::unique_lock lock(m_mutex);
 
+	for (std::atomic<System*>& slot : m_slots)
+	{
+		slot.store(nullptr, std::memory_order_release);
+	}
+
 	m_systemsMap.clear();
 	m_systems.clear();
-}
\ No newline at end of file
+
+	m_pipelineSlots.clear();
+	m_pipeline.reset();
+
+	m_waves.clear();
+	m_scheduleDirty = true;
+}
+
+#ifndef __EMSCRIPTEN__
+void SystemManager::SetThreadPool(BS::thread_pool<BS::tp::none>* threadPool)
+{
+	m_threadPool = threadPool;
+}
+#endif
+
+void SystemManager::BuildSchedule()
+{
+	m_waves.clear();
+
+	m_pipelineMainThread = false;
+
+	for (const auto& [slot, system] : m_pipelineSlots)
+	{
+		const SystemAccess& access = system->GetAccess();
+
+		// Systems without SetAccess call raylib like any undeclared dynamic system might
+		m_pipelineMainThread = m_pipelineMainThread || access.mainThread;
+
+		for (void (*assure)(Registry& registry) : access.pools)
+		{
+			assure(m_registry);
+		}
+	}
+
+	// Wave of every system, indexed like m_systems
+	std::vector<u32> waveOf(m_systems.size());
+
+	u32 bandStart = 0;
+	u32 bandWave = 0;
+
+	for (u32 i = 0; i < m_systems.size(); ++i)
+	{
+		const SystemAccess& access = m_systems[i].second->GetAccess();
+
+		// A new priority starts after every wave of the previous one
+		if (m_systems[i].first != m_systems[bandStart].first)
+		{
+			bandStart = i;
+			bandWave = m_waves.size();
+		}
+
+		u32 wave = bandWave;
+
+		for (u32 j = bandStart; j < i; ++j)
+		{
+			if (access.Conflicts(m_systems[j].second->GetAccess()))
+			{
+				wave = std::max(wave, waveOf[j] + 1);
+			}
+		}
+
+		waveOf[i] = wave;
+
+		if (wave >= m_waves.size())
+		{
+			m_waves.resize(wave + 1);
+		}
+
+		System* system = m_systems[i].second.get();
+		(access.mainThread ? m_waves[wave].mainThread : m_waves[wave].pooled).push_back(system);
+
+		for (void (*assure)(Registry& registry) : access.pools)
+		{
+			assure(m_registry);
+		}
+	}
+}
+
+void SystemManager::RunWave(const Wave& wave, const float deltaT, const Threads threads)
+{
+	TRACE_SCOPE("Wave");
+
+	const bool runPooled = threads != Threads::MAIN_THREAD;
+	const bool runMainThread = threads != Threads::POOLED;
+
+	const u64 pooledCount = runPooled ? wave.pooled.size() : 0;
+	const u64 mainThreadCount = runMainThread ? wave.mainThread.size() : 0;
+
+#ifndef __EMSCRIPTEN__
+	// Only worth handing off if something else runs at the same time
+	if (m_threadPool && pooledCount + mainThreadCount > 1)
+	{
+		BS::multi_future<void> futures = m_threadPool->submit_sequence(0, pooledCount,
+		[this, &wave, deltaT](const u64 i)
+		{
+			UpdateSystem(*wave.pooled[i], deltaT, m_step);
+		});
+
+		for (u64 i = 0; i < mainThreadCount; i++)
+		{
+			UpdateSystem(*wave.mainThread[i], deltaT, m_mainThreadStep);
+		}
+
+		// Rethrows anything a system threw
+		futures.get();
+
+		return;
+	}
+#endif
+
+	for (u64 i = 0; i < pooledCount; i++)
+	{
+		UpdateSystem(*wave.pooled[i], deltaT, m_step);
+	}
+
+	for (u64 i = 0; i < mainThreadCount; i++)
+	{
+		UpdateSystem(*wave.mainThread[i], deltaT, m_mainThreadStep);
+	}
+}
+
+void SystemManager::UpdateSystem(System& system, const float deltaT, const u64 step)
+{
+	float elapsed = 0;
+	if (TakeUpdate(system, deltaT, step, elapsed))
+	{
+		TimeCall(system, false, [&system, elapsed]
+		{
+			system.Update(elapsed);
+		});
+	}
+}
+
+bool SystemManager::TakeUpdate(System& system, const float deltaT, const u64 step, float& elapsed)
+{
+	if (system.m_divisor > 1)
+	{
+		system.m_pendingDeltaT += deltaT;
+
+		if (step % system.m_divisor != system.m_phase)
+		{
+			return false;
+		}
+	}
+
+	elapsed = system.m_divisor > 1 ? system.m_pendingDeltaT : deltaT;
+	system.m_pendingDeltaT = 0;
+
+	return true;
+}
+
+void SystemManager::RecordTime([[maybe_unused]] System& system, [[maybe_unused]] const bool draw,
+[[maybe_unused]] const double time)
+{
+#ifdef ENGINE_SYSTEM_PROFILING
+	(draw ? system.m_drawTiming : system.m_updateTiming).Add(time);
+
+	const double budget = draw ? system.m_drawBudget : system.m_updateBudget;
+	if (budget > 0 && time > budget)
+	{
+		std::unique_lock lock(m_overBudgetMutex);
+		m_overBudget.push_back({&system, draw, time, budget});
+	}
+#endif
+}
+
+void SystemManager::ClearPipelineSlots()
+{
+	// Leave slots a dynamic system has taken over since
+	for (auto [slot, system] : m_pipelineSlots)
+	{
+		m_slots[slot].compare_exchange_strong(system, nullptr, std::memory_order_acq_rel);
+	}
+
+	m_pipelineSlots.clear();
+}
+
+u32 SystemManager::PickPhase(const u32 divisor) const
+{
+	std::vector<u32> counts(divisor);
+
+	for (const auto& pair : m_systems)
+	{
+		if (pair.second->m_divisor == divisor)
+		{
+			counts[pair.second->m_phase]++;
+		}
+	}
+
+	return std::min_element(counts.begin(), counts.end()) - counts.begin();
+}
+
+void SystemManager::DrawSystem(System& system)
+{
+	TimeCall(system, true, [&system]
+	{
+		system.Draw();
+	});
+}
+
+void SystemManager::ReportOverBudget()
+{
+#ifdef ENGINE_SYSTEM_PROFILING
+	std::vector<OverBudget> overBudget;
+
+	{
+		std::unique_lock lock(m_overBudgetMutex);
+		std::swap(overBudget, m_overBudget);
+	}
+
+	for (const OverBudget& report : overBudget)
+	{
+		Logger::Write<LogLevel::WARN>(report.system->m_name, (report.draw ? " draw" : " update"), " took ",
+		report.time, "ms over its ", report.budget, "ms budget");
+
+		if (m_budgetCallback)
+		{
+			m_budgetCallback(report.system->m_name, report.draw, report.time, report.budget);
+		}
+	}
+#endif
+}
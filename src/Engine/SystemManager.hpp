@@ -1,12 +1,30 @@
 #pragma once
 
+#include "Assert.hpp"
 #include "NonCopyable.hpp"
 #include "Types.hpp"
 
+#include "Engine/Registry.hpp"
+#include "Engine/RenderSnapshot.hpp"
+#include "Engine/SystemPipeline.hpp"
+#include "Engine/Trace.hpp"
+#include "Log/Log.hpp"
+#include "Timing.hpp"
+#include "entt/entt.hpp"
+
+#ifndef __EMSCRIPTEN__
+#include "bsThreadPool/BS_thread_pool.hpp"
+#endif
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <string>
 #include <type_traits>
 #include <typeindex>
 #include <unordered_map>
@@ -18,24 +36,184 @@
  * @brief Engine lifelong systems and their managing.
  */
 
+/**
+ * @brief Declares what a system touches during Update
+ *
+ * Used by SystemManager to run systems of the same priority concurrently when
+ * they don't conflict. Two systems conflict if either is exclusive or one writes
+ * something the other reads or writes.
+ *
+ * Components are listed with Read and Write. Anything else shared between
+ * systems (a manager, a queue, the network) is listed with ReadResource and
+ * WriteResource using any type as the tag.
+ *
+ * Usage:
+ * @code
+ * SetAccess(SystemAccess{}.Read<Component::Transform>().Write<Component::Sprite>());
+ * @endcode
+ */
+struct SystemAccess
+{
+	/**
+	 * @brief Declares components read by the system
+	 *
+	 * @tparam Components Component types
+	 * @return Reference to this access for chaining
+	 */
+	template <typename... Components>
+	SystemAccess& Read()
+	{
+		(reads.push_back(entt::type_index<Components>::value()), ...);
+		(pools.push_back(&AssurePool<Components>), ...);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Declares components written by the system
+	 *
+	 * @tparam Components Component types
+	 * @return Reference to this access for chaining
+	 */
+	template <typename... Components>
+	SystemAccess& Write()
+	{
+		(writes.push_back(entt::type_index<Components>::value()), ...);
+		(pools.push_back(&AssurePool<Components>), ...);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Declares non component resources read by the system
+	 *
+	 * @tparam Resources Tag types identifying the resources
+	 * @return Reference to this access for chaining
+	 */
+	template <typename... Resources>
+	SystemAccess& ReadResource()
+	{
+		(reads.push_back(entt::type_index<Resources>::value()), ...);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Declares non component resources written by the system
+	 *
+	 * @tparam Resources Tag types identifying the resources
+	 * @return Reference to this access for chaining
+	 */
+	template <typename... Resources>
+	SystemAccess& WriteResource()
+	{
+		(writes.push_back(entt::type_index<Resources>::value()), ...);
+
+		return *this;
+	}
+
+	/**
+	 * @brief Checks whether two systems may not run at the same time
+	 *
+	 * @param other Access of the other system
+	 * @return True if they conflict
+	 */
+	bool Conflicts(const SystemAccess& other) const;
+
+	std::vector<u32> reads;
+	std::vector<u32> writes;
+
+	// Prepares the declared components up front so concurrent systems never create
+	// pools, signal tables or change tracking slots
+	std::vector<void (*)(Registry& registry)> pools;
+
+	/// Must run on the main thread (raylib, GL, window or audio device calls)
+	bool mainThread = false;
+
+	/// Conflicts with every other system
+	bool exclusive = false;
+
+private:
+
+	template <typename Component>
+	static void AssurePool(Registry& registry)
+	{
+		registry.Prepare<Component>();
+	}
+};
+
+/**
+ * @brief Timing of one system function over the recent calls
+ *
+ * All times are in milliseconds. Only collected when built with
+ * ENGINE_SYSTEM_PROFILING, otherwise everything stays zero.
+ */
+struct TimingStats
+{
+	double mean = 0;
+	double max = 0;
+	double p99 = 0;
+
+	/// Total calls since the system was added
+	u64 calls = 0;
+};
+
+/**
+ * @brief Update and Draw timings of one system, see SystemManager::GetTimings
+ */
+struct SystemTimings
+{
+	std::string name;
+	u32 priority = 0;
+
+	TimingStats update;
+	TimingStats draw;
+};
+
+/**
+ * @brief When a system updates, see SystemManager::AddSystem
+ *
+ * A system with a divisor of N updates on every Nth fixed step and receives the
+ * time accumulated since its previous update. With a 60 Hz step a divisor of 6
+ * gives a 10 Hz system.
+ */
+struct SystemSchedule
+{
+	/// Lower values run first
+	u32 priority = 1;
+
+	/// Update every this many fixed steps
+	u32 divisor = 1;
+
+	/// Step within the divisor to update on, chosen to spread the load if not given
+	std::optional<u32> phase;
+};
+
 /**
  * @brief Base class for all systems
  *
  * All systems must derive from this class and implement Update.
+ *
+ * Systems that don't declare their access with SetAccess are treated as
+ * exclusive and main thread only, so they run exactly as if updated one by one.
  */
 class System : public NonCopyable<>
 {
 public:
 
-	virtual ~System() = default;
+	/**
+	 * @brief Runs the cleanups added with AddCleanup, in reverse order
+	 */
+	virtual ~System();
 
 	/**
 	 * @brief Updates the system
 	 *
-	 * Called once per fixed-timestep step before rendering, in priority order.
+	 * Called once per fixed-timestep step before rendering, in priority order,
+	 * or every divisor-th step if added with a SystemSchedule.
 	 * Called before scenes.
 	 *
-	 * @param deltaT Duration of the previous frame in seconds
+	 * @param deltaT Time since the system's previous update in seconds
 	 */
 	virtual void Update(const float deltaT) = 0;
 
@@ -46,6 +224,154 @@ public:
 	 * Called before scenes. Default implementation does nothing.
 	 */
 	virtual void Draw() const;
+
+	/**
+	 * @brief Copies what Draw would draw into a render snapshot
+	 *
+	 * Only called when the Engine renders pipelined, on the main thread while
+	 * the simulation is idle. Systems whose Draw reads simulation state should
+	 * override this and skip that part of Draw when Engine::IsDrawingSnapshot,
+	 * as the snapshot is drawn while the next tick is simulated. Default implementation does nothing.
+	 *
+	 * @param snapshot Snapshot to append to
+	 */
+	virtual void Extract(RenderSnapshot& snapshot) const;
+
+	/**
+	 * @brief Returns true if nothing the system draws or plays changes over time
+	 *
+	 * Used by Engine idle throttling after each simulation. Systems that only change
+	 * what is drawn through registry signals can keep the default, which returns true.
+	 */
+	virtual bool IsIdle() const;
+
+	/**
+	 * @brief Returns what the system declared it touches during Update
+	 */
+	const SystemAccess& GetAccess() const;
+
+protected:
+
+	/**
+	 * @brief Declares what the system touches during Update
+	 *
+	 * Usually called from the constructor. May be called again later, the
+	 * SystemManager rebuilds its schedule on the next update.
+	 *
+	 * Systems that run off the main thread must not make structural registry
+	 * changes directly; record them in REGISTRY.GetCommandBuffer() instead.
+	 *
+	 * @param access Components and resources read and written
+	 */
+	void SetAccess(const SystemAccess& access);
+
+	/**
+	 * @brief Runs a function when the system is destroyed
+	 *
+	 * Systems registering registry callbacks that capture this must remove them
+	 * here, as systems are destroyed when removed, cleared or when a pipeline is
+	 * replaced while the registry lives on.
+	 *
+	 * Usage:
+	 * @code
+	 * const u32 id = REGISTRY.OnDestroy<Component::Sprite>(...);
+	 * AddCleanup([id] { REGISTRY.RemoveDestroyCallback<Component::Sprite>(id); });
+	 * @endcode
+	 *
+	 * @param cleanup Function to run
+	 */
+	void AddCleanup(std::function<void()> cleanup);
+
+private:
+
+	SystemAccess m_access = {.mainThread = true, .exclusive = true};
+
+	// Bumped by every SetAccess so managers know to rebuild their schedule
+	static inline std::atomic<u32> s_accessGeneration = 0;
+
+	std::string m_name;
+
+	// Outlives the system so trace events recorded for it stay valid
+	const char* m_traceName = nullptr;
+
+	std::vector<std::function<void()>> m_cleanups;
+
+	u32 m_divisor = 1;
+	u32 m_phase = 0;
+
+	// Time since the last update, for systems not updating every step
+	float m_pendingDeltaT = 0;
+
+#ifdef ENGINE_SYSTEM_PROFILING
+	// Ring buffer of the most recent call durations
+	struct TimingWindow
+	{
+		void Add(const double time);
+		TimingStats Compute() const;
+
+		std::array<float, 256> samples{};
+		u32 next = 0;
+		u32 count = 0;
+		u64 calls = 0;
+	};
+
+	TimingWindow m_updateTiming;
+	TimingWindow m_drawTiming;
+
+	// Zero means no budget
+	double m_updateBudget = 0;
+	double m_drawBudget = 0;
+#endif
+
+	friend class SystemManager;
+};
+
+/**
+ * @brief Cheap typed reference to a managed system
+ *
+ * Resolved once from SystemManager::GetHandle. Dereferencing is a single atomic
+ * load, with no lock, hash or cast. The handle stays valid for the manager's
+ * lifetime: after the system is removed it yields nullptr, and it picks the
+ * system up again if one of the same type is added later.
+ *
+ * @tparam SystemT System type
+ */
+template <typename SystemT>
+class SystemHandle
+{
+public:
+
+	SystemHandle(const std::atomic<System*>* slot) :
+	m_slot(slot)
+	{
+	}
+
+	/**
+	 * @brief Returns the system, or nullptr if none is currently added
+	 *
+	 * The pointer is only guaranteed to stay valid until the system is removed.
+	 */
+	SystemT* Get() const
+	{
+		return static_cast<SystemT*>(m_slot->load(std::memory_order_acquire));
+	}
+
+	SystemT* operator->() const
+	{
+		SystemT* system = Get();
+		Assert(system, "System is not managed");
+
+		return system;
+	}
+
+	explicit operator bool() const
+	{
+		return Get() != nullptr;
+	}
+
+private:
+
+	const std::atomic<System*>* m_slot = nullptr;
 };
 
 /**
@@ -54,12 +380,27 @@ public:
  * Systems are updated and drawn in ascending priority order.
  * Lower priority values execute first.
  * Systems update and draw before scenes each frame.
+ *
+ * Within one priority, systems are split into waves using their SystemAccess:
+ * a system goes in the wave after the last earlier system it conflicts with.
+ * The systems of a wave run concurrently on the thread pool, with main thread
+ * systems running on the calling thread meanwhile. Draw is always sequential.
+ * When the Engine is pipelined, main thread systems update on the main thread
+ * and the others on the simulation thread, see Engine::SetPipelined.
+ *
+ * An optional SystemPipeline runs before the dynamic systems on every update
+ * and draw.
  */
 class SystemManager
 {
 public:
 
-	SystemManager() = default;
+	/**
+	 * @brief Creates an empty manager
+	 *
+	 * @param registry Registry whose pools are created ahead of concurrent updates
+	 */
+	SystemManager(Registry& registry);
 
 	SystemManager(const SystemManager&) = delete;
 	SystemManager& operator=(const SystemManager&) = delete;
@@ -85,18 +426,59 @@ public:
 		requires std::is_base_of_v<System, SystemT>
 	std::shared_ptr<SystemT> AddSystem(const u32 priority = 1, Args&&... args)
 	{
+		return AddSystem<SystemT>(SystemSchedule{.priority = priority}, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * @brief Constructs a system that updates at a fraction of the fixed step rate
+	 *
+	 * Same as the priority overload but the system only updates on every
+	 * schedule.divisor-th step, receiving the summed deltaT of the skipped steps.
+	 * Without an explicit phase, the least used phase among systems with the same
+	 * divisor is picked so low frequency systems don't all land on the same step.
+	 *
+	 * @tparam SystemT System type (must derive from the System base class)
+	 * @tparam Args System constructor argument types
+	 * @param schedule Priority, divisor and optional phase
+	 * @param args Arguments forwarded to the system constructor
+	 * @return Shared pointer to the created system
+	 *
+	 * Usage:
+	 * @code
+	 * // 10 Hz at a 60 Hz fixed step
+	 * systemManager.AddSystem<AiSystem>(SystemSchedule{.priority = 2, .divisor = 6});
+	 * @endcode
+	 */
+	template <typename SystemT, typename... Args>
+		requires std::is_base_of_v<System, SystemT>
+	std::shared_ptr<SystemT> AddSystem(const SystemSchedule& schedule, Args&&... args)
+	{
+		Assert(schedule.divisor, "Divisor must be positive");
+		Assert(!schedule.phase || *schedule.phase < schedule.divisor, "Phase must be below the divisor");
+
 		std::unique_lock lock(m_mutex);
 
 		auto ptr = std::make_shared<SystemT>(std::forward<Args>(args)...);
+		ptr->m_name = DemangleWithoutNamespace<SystemT>();
+		ptr->m_traceName = Trace::Intern(ptr->m_name);
+		ptr->m_divisor = schedule.divisor;
+		ptr->m_phase = schedule.phase ? *schedule.phase : PickPhase(schedule.divisor);
 
+		const u32 priority = schedule.priority;
 		m_systems.push_back(std::make_pair(priority, ptr));
-		m_systemsMap.emplace(typeid(SystemT), ptr);
 
-		std::sort(m_systems.begin(), m_systems.end(), [](const auto& a, const auto& b)
+		if (m_systemsMap.emplace(typeid(SystemT), ptr).second)
+		{
+			m_slots[GetSlot<SystemT>()].store(ptr.get(), std::memory_order_release);
+		}
+
+		std::stable_sort(m_systems.begin(), m_systems.end(), [](const auto& a, const auto& b)
 		{
 			return a.first < b.first;
 		});
 
+		m_scheduleDirty = true;
+
 		return ptr;
 	}
 
@@ -104,6 +486,7 @@ public:
 	 * @brief Removes a system from the manager
 	 *
 	 * The system is destroyed when no more shared_ptrs to it remain.
+	 * Handles to it yield nullptr afterwards.
 	 * Does nothing if the system is not currently managed.
 	 *
 	 * @tparam SystemT System type to remove
@@ -121,6 +504,10 @@ public:
 		}
 
 		std::shared_ptr<System> ptr = it->second;
+
+		m_systemsMap.erase(it);
+		m_slots[GetSlot<SystemT>()].store(nullptr, std::memory_order_release);
+
 		i32 index = -1;
 
 		for (u32 i = 0; i < m_systems.size(); ++i)
@@ -136,6 +523,8 @@ public:
 		{
 			m_systems.erase(m_systems.begin() + index);
 		}
+
+		m_scheduleDirty = true;
 	}
 
 	/**
@@ -161,6 +550,151 @@ public:
 		return nullptr;
 	}
 
+	/**
+	 * @brief Returns a handle for fast repeated access to a system
+	 *
+	 * Prefer this over GetSystem on hot paths. The handle can be stored and
+	 * reused; see SystemHandle for its lifetime rules.
+	 *
+	 * @tparam SystemT System type
+	 * @return Handle to the system's slot
+	 *
+	 * Usage:
+	 * @code
+	 * SystemHandle<InputSystem> input = systemManager.GetHandle<InputSystem>();
+	 * if (input)
+	 * {
+	 *     input->SetScaling(scale, offset);
+	 * }
+	 * @endcode
+	 */
+	template <typename SystemT>
+		requires std::is_base_of_v<System, SystemT>
+	SystemHandle<SystemT> GetHandle()
+	{
+		return SystemHandle<SystemT>(&m_slots[GetSlot<SystemT>()]);
+	}
+
+	/**
+	 * @brief Sets the statically composed pipeline run before the dynamic systems
+	 *
+	 * Replaces any previous pipeline, destroying its systems. Handles to the
+	 * pipeline's system types resolve to its systems unless a dynamic system of
+	 * the same type is added later. Listing a type that is already added
+	 * dynamically is an error, as both instances would observe the registry.
+	 *
+	 * @tparam Pipeline A SystemPipeline specialisation
+	 * @return Reference to the created pipeline
+	 */
+	template <typename Pipeline>
+		requires std::is_base_of_v<PipelineBase, Pipeline>
+	Pipeline& SetPipeline()
+	{
+		std::unique_lock lock(m_mutex);
+
+		ClearPipelineSlots();
+
+		auto pipeline = std::make_unique<Pipeline>();
+		Pipeline& ref = *pipeline;
+
+		m_pipeline = std::move(pipeline);
+
+		RegisterPipelineSlots(ref);
+
+		m_scheduleDirty = true;
+
+		return ref;
+	}
+
+	/**
+	 * @brief Makes a system update at a fraction of the fixed step rate
+	 *
+	 * Same as the divisor and phase of the SystemSchedule given to AddSystem, and
+	 * the only way to schedule pipeline systems.
+	 *
+	 * @tparam SystemT System type, dynamic or in the pipeline
+	 * @param divisor Update every this many fixed steps
+	 * @param phase Step within the divisor to update on, chosen to spread the load if not given
+	 */
+	template <typename SystemT>
+		requires std::is_base_of_v<System, SystemT>
+	void SetSchedule(const u32 divisor, const std::optional<u32> phase = std::nullopt)
+	{
+		Assert(divisor, "Divisor must be positive");
+		Assert(!phase || *phase < divisor, "Phase must be below the divisor");
+
+		std::unique_lock lock(m_mutex);
+
+		System* system = m_slots[GetSlot<SystemT>()].load(std::memory_order_acquire);
+		Assert(system, "System is not managed");
+
+		system->m_divisor = divisor;
+		system->m_phase = phase ? *phase : PickPhase(divisor);
+		system->m_pendingDeltaT = 0;
+	}
+
+	/**
+	 * @brief Returns the timings of every managed system in priority order
+	 *
+	 * Pipeline systems come first with priority 0, as they run before the dynamic
+	 * systems. Covers the last 256 calls of each Update and Draw. Only filled in
+	 * when built with ENGINE_SYSTEM_PROFILING.
+	 *
+	 * @return Timings per system
+	 */
+	std::vector<SystemTimings> GetTimings();
+
+	/**
+	 * @brief Sets time budgets for a system
+	 *
+	 * Every call taking longer than its budget logs a warning and is passed to
+	 * the budget callback on the main thread. Does nothing unless built with
+	 * ENGINE_SYSTEM_PROFILING.
+	 *
+	 * @tparam SystemT System type
+	 * @param updateBudget Maximum Update time in milliseconds, zero for none
+	 * @param drawBudget Maximum Draw time in milliseconds, zero for none
+	 */
+	template <typename SystemT>
+		requires std::is_base_of_v<System, SystemT>
+	void SetBudget([[maybe_unused]] const double updateBudget, [[maybe_unused]] const double drawBudget = 0)
+	{
+#ifdef ENGINE_SYSTEM_PROFILING
+		std::unique_lock lock(m_mutex);
+
+		System* system = m_slots[GetSlot<SystemT>()].load(std::memory_order_acquire);
+		Assert(system, "System is not managed");
+
+		system->m_updateBudget = updateBudget;
+		system->m_drawBudget = drawBudget;
+#endif
+	}
+
+	/**
+	 * @brief Sets the function told about every call over its budget
+	 *
+	 * The Engine sets this to trigger Event::SystemOverBudget.
+	 *
+	 * @param callback Receives the system name, whether it was Draw, the time taken and the budget in milliseconds
+	 */
+	void SetBudgetCallback(
+	const std::function<void(const std::string& system, const bool draw, const double time, const double budget)>&
+	callback);
+
+#ifndef __EMSCRIPTEN__
+	/**
+	 * @brief Sets the thread pool waves are run on
+	 *
+	 * Called by the Engine constructor with the engine thread pool.
+	 *
+	 * @param threadPool Pool to run systems on, or nullptr to run everything on the calling thread
+	 */
+	void SetThreadPool(BS::thread_pool<BS::tp::none>* threadPool);
+#endif
+
+	/// Maximum number of distinct system types
+	static constexpr u32 MAX_SYSTEM_TYPES = 128;
+
 	/**
 	 * @brief Removes and destroys all managed systems
 	 *
@@ -170,22 +704,204 @@ public:
 
 private:
 
+	// Which systems an Update runs, the Engine splits them when pipelined
+	enum class Threads : u8
+	{
+		ALL,
+		MAIN_THREAD,
+		POOLED
+	};
+
 	/**
-	 * @brief Calls Update on all systems in priority order
+	 * @brief Calls Update on all due systems in priority order, wave by wave
+	 *
+	 * When only main thread or only pooled systems run, the other kind is left for
+	 * a matching call covering the same step. The pipeline counts as main thread
+	 * if any of its systems does, and as pooled otherwise.
 	 *
 	 * @param deltaT Duration of the previous frame in seconds
+	 * @param threads Systems to run
 	 */
-	void Update(const float deltaT);
+	void Update(const float deltaT, const Threads threads = Threads::ALL);
+
+	// Systems that may run at the same time
+	struct Wave
+	{
+		std::vector<System*> pooled;
+		std::vector<System*> mainThread;
+	};
+
+	void BuildSchedule();
+	void RunWave(const Wave& wave, const float deltaT, const Threads threads);
+
+	void UpdateSystem(System& system, const float deltaT, const u64 step);
+
+	// Adds deltaT to the system's pending time; returns true with the time to pass if it is due this step
+	static bool TakeUpdate(System& system, const float deltaT, const u64 step, float& elapsed);
+
+	// Traces and times a call to one of the system's functions, checking its budget
+	template <typename Func>
+	void TimeCall(System& system, const bool draw, Func&& func)
+	{
+		TRACE_SCOPE(system.m_traceName);
+
+#ifdef ENGINE_SYSTEM_PROFILING
+		Stopwatch timer;
+		timer.Start();
+
+		func();
+
+		RecordTime(system, draw, timer.Stop());
+#else
+		func();
+#endif
+	}
+
+	void RecordTime(System& system, const bool draw, const double time);
+
+	// Called by SystemPipeline, which keeps the calls qualified so they can be inlined
+	template <typename SystemT>
+	void UpdatePipelineSystem(SystemT& system, const float deltaT)
+	{
+		float elapsed = 0;
+		if (TakeUpdate(system, deltaT, m_pipelineMainThread ? m_mainThreadStep : m_step, elapsed))
+		{
+			TimeCall(system, false, [&system, elapsed]
+			{
+				system.SystemT::Update(elapsed);
+			});
+		}
+	}
+
+	template <typename SystemT>
+	void DrawPipelineSystem(SystemT& system)
+	{
+		TimeCall(system, true, [&system]
+		{
+			system.SystemT::Draw();
+		});
+	}
+
+	template <typename... Systems>
+		requires(std::is_base_of_v<System, Systems> && ...)
+	friend class SystemPipeline;
+
+	u32 PickPhase(const u32 divisor) const;
+
+	template <typename... Systems>
+	void RegisterPipelineSlots(SystemPipeline<Systems...>& pipeline)
+	{
+		auto registerSlot = [this]<typename SystemT>(SystemT& system)
+		{
+			Assert(!m_systemsMap.contains(typeid(SystemT)), "Pipeline system type is already added dynamically");
+
+			system.m_name = DemangleWithoutNamespace<SystemT>();
+			system.m_traceName = Trace::Intern(system.m_name);
+
+			const u32 slot = GetSlot<SystemT>();
+
+			System* expected = nullptr;
+			if (m_slots[slot].compare_exchange_strong(expected, &system, std::memory_order_acq_rel))
+			{
+				m_pipelineSlots.emplace_back(slot, &system);
+			}
+		};
+
+		(registerSlot(pipeline.template Get<Systems>()), ...);
+	}
+
+	void ClearPipelineSlots();
+	void DrawSystem(System& system);
+
+	void ReportOverBudget();
+
+	struct OverBudget
+	{
+		const System* system = nullptr;
+		bool draw = false;
+		double time = 0;
+		double budget = 0;
+	};
 
 	/**
 	 * @brief Calls Draw on all systems in priority order
 	 */
 	void Draw();
 
+	/**
+	 * @brief Calls Extract on all systems in priority order
+	 *
+	 * @param snapshot Snapshot to append to
+	 */
+	void Extract(RenderSnapshot& snapshot);
+
+	/**
+	 * @brief Returns true if the pipeline and every system are idle
+	 */
+	bool IsIdle();
+
+	// Assigned once per system type on first use, shared by all managers
+	template <typename SystemT>
+	static u32 GetSlot()
+	{
+		static const u32 s_slot = s_nextSlot++;
+		Assert(s_slot < MAX_SYSTEM_TYPES, "Too many system types");
+
+		return s_slot;
+	}
+
+	static inline std::atomic<u32> s_nextSlot = 0;
+
 	std::shared_mutex m_mutex;
 
+	// Raw pointers to the systems by slot, owned by m_systems
+	std::array<std::atomic<System*>, MAX_SYSTEM_TYPES> m_slots{};
+
 	std::vector<std::pair<u32, std::shared_ptr<System>>> m_systems;
+
+	Registry& m_registry;
+
+	std::vector<Wave> m_waves;
+
+	std::unique_ptr<PipelineBase> m_pipeline;
+
+	// Slots pointing into the pipeline, cleared when it is replaced
+	std::vector<std::pair<u32, System*>> m_pipelineSlots;
+
+	// Set when a pipeline system must run on the main thread, which then runs the whole pipeline
+	bool m_pipelineMainThread = false;
+
+	// Fixed steps run so far by pooled and main thread systems, decides which divided systems are due
+	u64 m_step = 0;
+	u64 m_mainThreadStep = 0;
+
+	// Filled from any thread, reported on the main thread
+	std::mutex m_overBudgetMutex;
+	std::vector<OverBudget> m_overBudget;
+
+	std::function<void(const std::string& system, const bool draw, const double time, const double budget)>
+	m_budgetCallback;
+	bool m_scheduleDirty = true;
+	u32 m_accessGeneration = 0;
+
+#ifndef __EMSCRIPTEN__
+	BS::thread_pool<BS::tp::none>* m_threadPool = nullptr;
+#endif
 	std::unordered_map<std::type_index, std::shared_ptr<System>> m_systemsMap;
 
 	friend class Engine;
-};
\ No newline at end of file
+};
+
+template <typename... Systems>
+	requires(std::is_base_of_v<System, Systems> && ...)
+void SystemPipeline<Systems...>::Update(SystemManager& manager, const float deltaT)
+{
+	(manager.UpdatePipelineSystem(std::get<Systems>(m_systems), deltaT), ...);
+}
+
+template <typename... Systems>
+	requires(std::is_base_of_v<System, Systems> && ...)
+void SystemPipeline<Systems...>::Draw(SystemManager& manager)
+{
+	(manager.DrawPipelineSystem(std::get<Systems>(m_systems)), ...);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include "Engine/RenderSnapshot.hpp"
+
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @file SystemPipeline.hpp
+ * @brief Compile time composed system pipelines.
+ */
+
+class System;
+class SystemManager;
+
+/**
+ * @brief Type erased pipeline interface used by SystemManager
+ *
+ * Costs one virtual call per Update or Draw for the whole pipeline.
+ */
+class PipelineBase : public NonCopyable<>
+{
+public:
+
+	virtual ~PipelineBase() = default;
+
+	/**
+	 * @brief Updates every system of the pipeline in order
+	 *
+	 * @param manager Manager applying schedules, timings and budgets around each system
+	 * @param deltaT Duration of the fixed step in seconds
+	 */
+	virtual void Update(SystemManager& manager, const float deltaT) = 0;
+
+	/**
+	 * @brief Draws every system of the pipeline in order
+	 *
+	 * @param manager Manager applying timings and budgets around each system
+	 */
+	virtual void Draw(SystemManager& manager) = 0;
+
+	/**
+	 * @brief Extracts every system of the pipeline in order
+	 *
+	 * @param snapshot Snapshot to append to
+	 */
+	virtual void Extract(RenderSnapshot& snapshot) = 0;
+
+	/**
+	 * @brief Returns true if every system of the pipeline is idle
+	 */
+	virtual bool IsIdle() const = 0;
+};
+
+/**
+ * @brief A fixed list of systems updated without virtual dispatch
+ *
+ * The systems are stored by value and their Update and Draw are called through
+ * qualified names, so the compiler sees the concrete functions and can inline
+ * the whole tick. Meant for builds whose set of systems is known up front, such
+ * as a dedicated server. Runtime added systems keep using SystemManager.
+ *
+ * Systems run in the order they are listed, on the calling thread. When the
+ * Engine is pipelined, the whole pipeline updates on the main thread if any of
+ * its systems declared mainThread or never called SetAccess, and on the
+ * simulation thread otherwise. They are timed, traced and budgeted like dynamic
+ * systems, listed first by SystemManager::GetTimings, and can update at a
+ * fraction of the step rate through SystemManager::SetSchedule. Marking them
+ * final documents that their overrides are what gets called.
+ *
+ * Usage:
+ * @code
+ * // Engine adds its own systems (input, audio, particles, networking, animation) dynamically, don't list them
+ * using ServerPipeline = SystemPipeline<PhysicsSystem, AiSystem>;
+ *
+ * SYSTEM_MANAGER.SetPipeline<ServerPipeline>();
+ * @endcode
+ *
+ * @tparam Systems System types, each default constructible and derived from System
+ */
+template <typename... Systems>
+	requires(std::is_base_of_v<System, Systems> && ...)
+class SystemPipeline final : public PipelineBase
+{
+public:
+
+	// Defined in SystemManager.hpp, which needs this class complete first
+	void Update(SystemManager& manager, const float deltaT) override;
+	void Draw(SystemManager& manager) override;
+
+	void Extract(RenderSnapshot& snapshot) override
+	{
+		(std::get<Systems>(m_systems).Systems::Extract(snapshot), ...);
+	}
+
+	bool IsIdle() const override
+	{
+		return (std::get<Systems>(m_systems).Systems::IsIdle() && ...);
+	}
+
+	/**
+	 * @brief Returns one of the pipeline's systems
+	 *
+	 * @tparam SystemT System type listed in the pipeline
+	 * @return Reference to the system
+	 */
+	template <typename SystemT>
+	SystemT& Get()
+	{
+		return std::get<SystemT>(m_systems);
+	}
+
+private:
+
+	std::tuple<Systems...> m_systems;
+};
@@ -5,18 +5,19 @@
 #include "raylib.h"
 #include <cmath>
 
-void AnimationSystem::Update([[maybe_unused]] const float deltaT)
+AnimationSystem::AnimationSystem()
 {
-	auto view = REGISTRY.GetView<Component::Animation, Component::Sprite>();
+	SetAccess(SystemAccess{}.Write<Component::Animation, Component::Sprite>());
+}
 
-	for (auto [entity, anim, sprt] : view.each())
+void AnimationSystem::Update([[maybe_unused]] const float deltaT)
+{
+	REGISTRY.ForEach<Component::Animation, Component::Sprite>(
+	[deltaT](const Entity entity, Component::Animation& animation, Component::Sprite& sprite)
 	{
-		auto animation = anim;
-		auto sprite = sprt;
-
 		if (!animation.playing || animation.frames.empty())
 		{
-			continue;
+			return;
 		}
 
 		float newTime = animation.time + (deltaT * animation.speed);
@@ -26,6 +27,8 @@ void AnimationSystem::Update([[maybe_unused]] const float deltaT)
 		{
 			newTime = totalDuration - 0.001f;
 			animation.playing = false;
+
+			REGISTRY.MarkChanged<Component::Animation>(entity);
 		}
 
 		else if (animation.loop)
@@ -38,12 +41,19 @@ void AnimationSystem::Update([[maybe_unused]] const float deltaT)
 		int frameIndex = (int)(animation.time / animation.frameDuration) % animation.frames.size();
 		const Rectangle& frameRect = animation.frames[frameIndex];
 
+		// Only notify sprite observers when the displayed frame actually changes
+		if (sprite.texture.id == animation.texture.id && sprite.rectangle.x == frameRect.x &&
+			sprite.rectangle.y == frameRect.y && sprite.rectangle.width == frameRect.width &&
+			sprite.rectangle.height == frameRect.height)
+		{
+			return;
+		}
+
 		sprite.texture = animation.texture;
 		sprite.rectangle = frameRect;
 
-		REGISTRY.Replace<Component::Animation>(entity, animation);
-		REGISTRY.Replace<Component::Sprite>(entity, sprite);
-	}
+		REGISTRY.MarkChanged<Component::Sprite>(entity);
+	});
 }
 
 Component::Animation AnimationSystem::GridAnimation(const Texture2D texture, const u32 cellWidth, const u32 cellHeight,
@@ -18,12 +18,18 @@ class AnimationSystem : public System
 {
 public:
 
+	/**
+	 * @brief Constructs the system and declares its component access.
+	 */
+	AnimationSystem();
+
 	/**
 	 * @brief Updates all animations.
 	 * @param deltaT Time since last update (seconds).
 	 *
 	 * Advances the animation time, calculates the current frame,
-	 * and updates the sprite's texture rectangle.
+	 * and updates the sprite's texture rectangle in place.
+	 * Sprite update callbacks only fire when the displayed frame changes.
 	 */
 	void Update(const float deltaT) override;
 
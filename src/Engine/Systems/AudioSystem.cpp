@@ -1,4 +1,5 @@
 #include "AudioSystem.hpp"
+#include "Engine/Engine.hpp"
 #include "Log/Logger.hpp"
 #include "raylib.h"
 #include <algorithm>
@@ -6,7 +7,7 @@
 
 void AudioSystem::Update([[maybe_unused]] const float deltaT)
 {
-	std::vector<rAudioBuffer*> toRemove;
+	std::pmr::vector<rAudioBuffer*> toRemove(FRAME_ARENA.Resource());
 
 	for (auto& [buffer, pair] : m_sounds)
 	{
@@ -97,6 +98,12 @@ void AudioSystem::Update([[maybe_unused]] const float deltaT)
 	}
 }
 
+bool AudioSystem::IsIdle() const
+{
+	return m_musicState != MusicState::FADING_IN && m_musicState != MusicState::FADING_OUT &&
+		   m_musicState != MusicState::QUEUED;
+}
+
 void AudioSystem::PlaySound(const Sound& sound, float volume)
 {
 	if (!IsSoundValid(sound))
@@ -410,6 +417,11 @@ void AudioSystem::SetMusicLoop(const bool loop)
 
 void AudioSystem::SetMasterVolume(float volume)
 {
+	if (!IsAudioDeviceReady())
+	{
+		return;
+	}
+
 	volume = std::clamp(volume, 0.0f, 1.0f);
 
 	::SetMasterVolume(volume);
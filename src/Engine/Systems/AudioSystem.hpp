@@ -25,6 +25,11 @@ public:
 	 */
 	void Update(const float deltaT) override;
 
+	/**
+	 * @brief Returns true unless music is fading or waiting to swap.
+	 */
+	bool IsIdle() const override;
+
 	// --- Sound effects -------------------------------------------------
 
 	/**
@@ -41,6 +41,44 @@ void InputSystem::Update([[maybe_unused]] const float deltaT)
 	}
 }
 
+bool InputSystem::IsIdle() const
+{
+	const Vector2 mouseDelta = GetMouseDelta();
+	if (mouseDelta.x != 0 || mouseDelta.y != 0 || GetMouseWheelMove() != 0 || GetTouchPointCount())
+	{
+		return false;
+	}
+
+	for (i32 button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_BACK; button++)
+	{
+		if (IsMouseButtonDown(button))
+		{
+			return false;
+		}
+	}
+
+	// Any key, bound or not, since text fields and other polled input read it directly.
+	// Typed characters come from key presses, and raylib's key and char queues can't be
+	// peeked without taking them from whoever reads them
+	for (i32 key = KEY_NULL + 1; key <= KEY_KP_EQUAL; key++)
+	{
+		if (IsKeyDown(key) || IsKeyReleased(key))
+		{
+			return false;
+		}
+	}
+
+	for (const auto& [name, state] : m_states)
+	{
+		if (state.boolean || state.number != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void InputSystem::BindInput(const std::string& name, const Input& input)
 {
 	if (!m_inputs.contains(name))
@@ -88,6 +88,14 @@ public:
 	 */
 	void Update(const float deltaT) override;
 
+	/**
+	 * @brief Returns true if the mouse is still, no binding is held and no key is down or released.
+	 *
+	 * Checks every key, so input read directly rather than through bindings, such as typed
+	 * text, also keeps the engine awake.
+	 */
+	bool IsIdle() const override;
+
 	/**
 	 * @brief Adds an input to a logical binding.
 	 * @param name Logical action name.
@@ -7,15 +7,25 @@
 NetworkEntitySystem::NetworkEntitySystem() :
 m_registry(REGISTRY)
 {
-	REGISTRY.OnConstruct<Component::NetworkId>([this](Component::NetworkId& networkId, const Entity entity)
+	SetAccess(SystemAccess{}.Read<Component::NetworkId>().WriteResource<NetworkEntitySystem>());
+
+	const u32 construct =
+	m_registry.OnConstruct<Component::NetworkId>([this](Component::NetworkId& networkId, const Entity entity)
 	{
 		OnConstruct(networkId, entity);
 	});
 
-	REGISTRY.OnDestroy<Component::NetworkId>([this](Component::NetworkId& networkId, const Entity entity)
+	const u32 destroy =
+	m_registry.OnDestroy<Component::NetworkId>([this](Component::NetworkId& networkId, const Entity entity)
 	{
 		OnDestroy(networkId, entity);
 	});
+
+	AddCleanup([this, construct, destroy]
+	{
+		m_registry.RemoveConstructCallback<Component::NetworkId>(construct);
+		m_registry.RemoveDestroyCallback<Component::NetworkId>(destroy);
+	});
 }
 
 void NetworkEntitySystem::Update([[maybe_unused]] const float deltaT)
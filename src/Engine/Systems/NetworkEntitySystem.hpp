@@ -9,7 +9,9 @@
 #include "cereal/MyCereal.h"
 #include <cereal/types/array.hpp>
 #include <cereal/types/vector.hpp>
+#include <algorithm>
 #include <cstddef>
+#include <typeindex>
 #include <unordered_map>
 
 using NetPeerId = UUID;
@@ -58,7 +60,8 @@ public:
 	 * @brief Constructs the system and registers component callbacks.
 	 *
 	 * Subscribes to `OnConstruct` and `OnDestroy` events for `Component::NetworkId`
-	 * to keep the internal mapping synchronised.
+	 * to keep the internal mapping synchronised. Declares read access to the
+	 * networked components so the scheduler can run it alongside other systems.
 	 */
 	NetworkEntitySystem();
 
@@ -134,10 +137,25 @@ public:
 
 		m_networkedComponents[entity].emplace(typeid(ComponentT), reliable);
 
-		m_registry.OnUpdate<ComponentT>([this](ComponentT& component, const Entity entity)
+		// Systems writing this component feed m_updates through OnUpdate, so they must not overlap with Update
+		const std::vector<u32>& reads = GetAccess().reads;
+		if (std::find(reads.begin(), reads.end(), entt::type_index<ComponentT>::value()) == reads.end())
+		{
+			SystemAccess access = GetAccess();
+			access.Read<ComponentT>();
+
+			SetAccess(access);
+		}
+
+		const u32 update = m_registry.OnUpdate<ComponentT>([this](ComponentT& component, const Entity entity)
 		{
 			OnUpdate(component, entity);
 		});
+
+		AddCleanup([this, update]
+		{
+			m_registry.RemoveUpdateCallback<ComponentT>(update);
+		});
 	}
 
 private:
@@ -5,96 +5,149 @@
 
 #include "Utils/RaylibUtils.hpp"
 #include "raylib.h"
+#include <algorithm>
+#include <cmath>
 #include <execution>
+#include <limits>
 #include <random>
 
 static float RandFloat(const float min, const float max);
 static float RandAngleDeg();
 static Color LerpColor(const Color& a, const Color& b, const float t);
 
+template <typename Func>
+static void ForEachVisibleParticle(const SpatialGrid& grid, std::vector<Entity>& emitters, Func&& func);
+
 ParticleSystem::ParticleSystem()
 {
-	REGISTRY.OnConstruct<Component::Particle>([this](Component::Particle&, const Entity)
+	SystemAccess access;
+	access.Read<Component::Transform>();
+	access.Write<Component::ParticleEmitter, std::vector<Component::Particle>, Component::Particle>();
+
+	SetAccess(access);
+
+	Registry& registry = REGISTRY;
+
+	const u32 particleConstruct = registry.OnConstruct<Component::Particle>([this](Component::Particle&, const Entity)
 	{
 		MarkNeedSort();
 	});
 
-	REGISTRY.OnUpdate<Component::Particle>([this](Component::Particle&, const Entity)
+	const u32 particleUpdate = registry.OnUpdate<Component::Particle>([this](Component::Particle&, const Entity)
 	{
 		MarkNeedSort();
 	});
 
-	REGISTRY.OnDestroy<Component::Particle>([this](Component::Particle&, const Entity)
+	const u32 particleDestroy = registry.OnDestroy<Component::Particle>([this](Component::Particle&, const Entity)
 	{
 		MarkNeedSort();
 	});
+
+	// Bursts and newly emplaced particle vectors land outside of Update
+	const u32 vectorConstruct = registry.OnConstruct<std::vector<Component::Particle>>(
+	[this](std::vector<Component::Particle>& particles, const Entity entity)
+	{
+		UpdateBounds(entity, particles);
+	});
+
+	const u32 vectorUpdate = registry.OnUpdate<std::vector<Component::Particle>>(
+	[this](std::vector<Component::Particle>& particles, const Entity entity)
+	{
+		UpdateBounds(entity, particles);
+	});
+
+	const u32 vectorDestroy = registry.OnDestroy<std::vector<Component::Particle>>(
+	[this](std::vector<Component::Particle>&, const Entity entity)
+	{
+		m_grid.Remove(entity);
+	});
+
+	AddCleanup([&registry, particleConstruct, particleUpdate, particleDestroy, vectorConstruct, vectorUpdate,
+	vectorDestroy]
+	{
+		registry.RemoveConstructCallback<Component::Particle>(particleConstruct);
+		registry.RemoveUpdateCallback<Component::Particle>(particleUpdate);
+		registry.RemoveDestroyCallback<Component::Particle>(particleDestroy);
+
+		registry.RemoveConstructCallback<std::vector<Component::Particle>>(vectorConstruct);
+		registry.RemoveUpdateCallback<std::vector<Component::Particle>>(vectorUpdate);
+		registry.RemoveDestroyCallback<std::vector<Component::Particle>>(vectorDestroy);
+	});
 }
 
 void ParticleSystem::Update(const float deltaT) // NOLINT
 {
-	auto view = REGISTRY.GetView<std::vector<Component::Particle>, Component::ParticleEmitter>();
-
-	for (auto [entity, particles, emitter] : view.each())
+	REGISTRY.ForEach<Component::ParticleEmitter>(
+	[this, deltaT](const Entity entity, Component::ParticleEmitter& emitter)
 	{
-		auto particlesCopy = particles;
-		auto emitterCopy = emitter;
-
+		auto* particles = REGISTRY.GetMutable<std::vector<Component::Particle>>(entity);
 		bool particlesDirty = false;
-		bool emitterDirty = false;
 
-		for (auto it = particlesCopy.begin(); it != particlesCopy.end();)
+		if (particles)
 		{
-			it->age += deltaT;
-			it->rotation += it->angularVelocity * deltaT;
-			it->velocity.y += emitterCopy.gravity * deltaT;
-			it->position.x += it->velocity.x * deltaT;
-			it->position.y += it->velocity.y * deltaT;
+			const u64 oldCount = particles->size();
 
-			if (it->age >= it->lifetime)
+			for (Component::Particle& particle : *particles)
 			{
-				it = particlesCopy.erase(it);
-				particlesDirty = true;
+				particle.age += deltaT;
+				particle.rotation += particle.angularVelocity * deltaT;
+				particle.velocity.y += emitter.gravity * deltaT;
+				particle.position.x += particle.velocity.x * deltaT;
+				particle.position.y += particle.velocity.y * deltaT;
 			}
-			else
+
+			std::erase_if(*particles, [](const Component::Particle& particle)
 			{
-				++it;
-			}
+				return particle.age >= particle.lifetime;
+			});
+
+			particlesDirty = particles->size() != oldCount;
 		}
 
-		if (emitterCopy.playing && emitterCopy.spawnRate > 0)
+		if (emitter.playing && emitter.spawnRate > 0)
 		{
 			const auto* transform = REGISTRY.Get<Component::Transform>(entity);
 			if (transform)
 			{
-				emitterCopy.spawnAccumulator += emitterCopy.spawnRate * deltaT;
-				emitterDirty = true;
+				emitter.spawnAccumulator += emitter.spawnRate * deltaT;
 
-				while (emitterCopy.spawnAccumulator >= 1)
+				std::pmr::vector<Component::Particle> spawned(FRAME_ARENA.Resource());
+
+				while (emitter.spawnAccumulator >= 1)
 				{
-					SpawnParticle(entity, emitterCopy, transform->position);
-					emitterCopy.spawnAccumulator -= 1;
+					spawned.push_back(CreateParticle(emitter, transform->position));
+					emitter.spawnAccumulator -= 1;
+				}
 
-					const auto* updated = REGISTRY.Get<std::vector<Component::Particle>>(entity);
-					if (updated)
+				if (!spawned.empty())
+				{
+					if (particles)
 					{
-						particlesCopy = *updated;
+						particles->insert(particles->end(), spawned.begin(), spawned.end());
+						particlesDirty = true;
 					}
-				}
 
-				particlesDirty = true;
+					// The particle pool can't be added to while the emitters are being iterated
+					else
+					{
+						REGISTRY.GetCommandBuffer().Emplace<std::vector<Component::Particle>>(entity,
+						std::vector<Component::Particle>(spawned.begin(), spawned.end()));
+					}
+				}
 			}
 		}
 
 		if (particlesDirty)
 		{
-			REGISTRY.Replace<std::vector<Component::Particle>>(entity, particlesCopy);
+			REGISTRY.MarkChanged<std::vector<Component::Particle>>(entity);
 		}
 
-		if (emitterDirty)
+		// Changed vectors get their bounds from the update signal once flushed
+		else if (particles)
 		{
-			REGISTRY.Replace<Component::ParticleEmitter>(entity, emitterCopy);
+			UpdateBounds(entity, *particles);
 		}
-	}
+	});
 
 	if (m_needSort)
 	{
@@ -109,46 +162,57 @@ void ParticleSystem::Update(const float deltaT) // NOLINT
 
 void ParticleSystem::Draw() const
 {
-	auto view = REGISTRY.GetView<std::vector<Component::Particle>>();
+	// Already drawn from Extract
+	if (Engine::Get().IsDrawingSnapshot())
+	{
+		return;
+	}
 
 	BeginMode2D(RENDERER.camera);
 
-	for (auto [entity, particles] : view.each())
+	ForEachVisibleParticle(m_grid, m_visibleEmitters, [](const RenderItem& item)
 	{
-		for (const auto& particle : particles)
+		if (item.circle)
 		{
-			const float t = (particle.lifetime > 0) ? (particle.age / particle.lifetime) : 1;
-			const Color color = LerpColor(particle.startColor, particle.endColor, t);
-			const float size = particle.startSize + ((particle.endSize - particle.startSize) * t);
+			DrawCircleV({item.dest.x, item.dest.y}, item.dest.width, item.color);
+		}
 
-			if (size <= 0.f || color.a == 0)
-			{
-				continue;
-			}
+		else
+		{
+			DrawTexturePro(item.texture, item.source, item.dest, item.origin, item.rotation, item.color);
+		}
+	});
 
-			if (IsTextureValid(particle.texture) &&
-				IsTextureVisible(particle.texture, 1, particle.position.Raylib(), RENDERER.camera))
-			{
-				const float halfW = (particle.texRect.width * size) * 0.5;
-				const float halfH = (particle.texRect.height * size) * 0.5;
+	EndMode2D();
+}
 
-				Rectangle dest = {particle.position.x, particle.position.y, halfW * 2, halfH * 2};
-				Vector2 origin = {halfW, halfH};
+void ParticleSystem::Extract(RenderSnapshot& snapshot) const
+{
+	ForEachVisibleParticle(m_grid, m_visibleEmitters, [&snapshot](const RenderItem& item)
+	{
+		snapshot.items.push_back(item);
+	});
+}
 
-				DrawTexturePro(particle.texture, particle.texRect, dest, origin, particle.rotation, color);
-			}
+bool ParticleSystem::IsIdle() const
+{
+	for (auto [entity, particles] : REGISTRY.GetView<std::vector<Component::Particle>>().each())
+	{
+		if (!particles.empty())
+		{
+			return false;
+		}
+	}
 
-			else
-			{
-				if (IsCircleVisible(size, particle.position.Raylib(), RENDERER.camera))
-				{
-					DrawCircleV(particle.position.Raylib(), size, color);
-				}
-			}
+	for (auto [entity, emitter] : REGISTRY.GetView<Component::ParticleEmitter>().each())
+	{
+		if (emitter.playing && emitter.spawnRate > 0)
+		{
+			return false;
 		}
 	}
 
-	EndMode2D();
+	return true;
 }
 
 void ParticleSystem::Burst(const Entity entity, const u32 count)
@@ -185,6 +249,22 @@ void ParticleSystem::Play(const Entity entity)
 
 void ParticleSystem::SpawnParticle(const Entity entity, const Component::ParticleEmitter& emitter,
 const Vec2<float>& worldPos)
+{
+	Component::Particle particle = CreateParticle(emitter, worldPos);
+
+	if (!REGISTRY.HasAny<std::vector<Component::Particle>>(entity))
+	{
+		REGISTRY.Emplace<std::vector<Component::Particle>>(entity);
+	}
+
+	REGISTRY.Patch<std::vector<Component::Particle>>(entity, [&particle](std::vector<Component::Particle>& particles)
+	{
+		particles.push_back(particle);
+	});
+}
+
+Component::Particle ParticleSystem::CreateParticle(const Component::ParticleEmitter& emitter,
+const Vec2<float>& worldPos)
 {
 	Component::Particle particle;
 
@@ -223,15 +303,47 @@ const Vec2<float>& worldPos)
 		particle.endSize = emitter.endSize;
 	}
 
-	if (!REGISTRY.HasAny<std::vector<Component::Particle>>(entity))
+	return particle;
+}
+
+void ParticleSystem::UpdateBounds(const Entity entity, const std::vector<Component::Particle>& particles)
+{
+	if (particles.empty())
 	{
-		REGISTRY.Emplace<std::vector<Component::Particle>>(entity);
+		m_grid.Remove(entity);
+
+		return;
 	}
 
-	REGISTRY.Patch<std::vector<Component::Particle>>(entity, [&particle](std::vector<Component::Particle>& particles)
+	// Drawing rewinds particles by up to one fixed step
+	const float rewind = Engine::Get().GetFixedTimeStep();
+
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float maxY = std::numeric_limits<float>::lowest();
+
+	for (const Component::Particle& particle : particles)
 	{
-		particles.push_back(particle);
-	});
+		const float size = std::max(particle.startSize, particle.endSize);
+
+		// Half diagonal of the drawn quad, or the circle radius
+		float extent = size;
+		if (IsTextureValid(particle.texture))
+		{
+			extent = std::hypot(particle.texRect.width, particle.texRect.height) * size * 0.5f;
+		}
+
+		const float pastX = particle.position.x - (particle.velocity.x * rewind);
+		const float pastY = particle.position.y - (particle.velocity.y * rewind);
+
+		minX = std::min(minX, std::min(particle.position.x, pastX) - extent);
+		minY = std::min(minY, std::min(particle.position.y, pastY) - extent);
+		maxX = std::max(maxX, std::max(particle.position.x, pastX) + extent);
+		maxY = std::max(maxY, std::max(particle.position.y, pastY) + extent);
+	}
+
+	m_grid.Update(entity, {minX, minY, maxX - minX, maxY - minY});
 }
 
 void ParticleSystem::MarkNeedSort()
@@ -261,4 +373,69 @@ static Color LerpColor(const Color& a, const Color& b, const float t)
 	static_cast<unsigned char>(a.b + ((b.b - a.b) * t)),
 	static_cast<unsigned char>(a.a + ((b.a - a.a) * t)),
 	};
-}
\ No newline at end of file
+}
+
+template <typename Func>
+static void ForEachVisibleParticle(const SpatialGrid& grid, std::vector<Entity>& emitters, Func&& func)
+{
+	const auto& pool = REGISTRY.GetRegistry().storage<std::vector<Component::Particle>>();
+
+	// Only emitters whose particle bounds reach the camera are looked at
+	emitters.clear();
+	grid.Query(GetCameraRectangle(RENDERER.camera), emitters);
+
+	std::erase_if(emitters, [&pool](const Entity entity)
+	{
+		return !pool.contains(entity);
+	});
+
+	// Keep the pool's draw order between overlapping emitters
+	std::sort(emitters.begin(), emitters.end(), [&pool](const Entity a, const Entity b)
+	{
+		return pool.index(a) > pool.index(b);
+	});
+
+	// Particles hold the state of the latest step; step back by velocity to where
+	// they were at the interpolated time instead of storing previous positions
+	const float rewind = (1 - Engine::Get().GetInterpolationAlpha()) * Engine::Get().GetFixedTimeStep();
+
+	for (const Entity entity : emitters)
+	{
+		for (const auto& particle : pool.get(entity))
+		{
+			const float t = (particle.lifetime > 0) ? (particle.age / particle.lifetime) : 1;
+			const Color color = LerpColor(particle.startColor, particle.endColor, t);
+			const float size = particle.startSize + ((particle.endSize - particle.startSize) * t);
+
+			if (size <= 0.f || color.a == 0)
+			{
+				continue;
+			}
+
+			const Vector2 position = {particle.position.x - (particle.velocity.x * rewind),
+			particle.position.y - (particle.velocity.y * rewind)};
+			const float rotation = particle.rotation - (particle.angularVelocity * rewind);
+
+			if (IsTextureValid(particle.texture) && IsTextureVisible(particle.texture, 1, position, RENDERER.camera))
+			{
+				const float halfW = (particle.texRect.width * size) * 0.5;
+				const float halfH = (particle.texRect.height * size) * 0.5;
+
+				func(RenderItem{.texture = particle.texture,
+				.source = particle.texRect,
+				.dest = {position.x, position.y, halfW * 2, halfH * 2},
+				.origin = {halfW, halfH},
+				.rotation = rotation,
+				.color = color});
+			}
+
+			else
+			{
+				if (IsCircleVisible(size, position, RENDERER.camera))
+				{
+					func(RenderItem{.dest = {position.x, position.y, size, size}, .color = color, .circle = true});
+				}
+			}
+		}
+	}
+}
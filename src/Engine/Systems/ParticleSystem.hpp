@@ -2,6 +2,7 @@
 
 #include "Engine/Components.hpp"
 #include "Engine/Registry.hpp"
+#include "Engine/SpatialGrid.hpp"
 #include "Engine/SystemManager.hpp"
 
 /**
@@ -13,16 +14,18 @@
  * @class ParticleSystem
  * @brief Updates and draws particles emitted by entities.
  *
- * Requires entities to have a Component::ParticleEmitter and a
- * std::vector<Component::Particle>. Handles spawning, physics,
- * aging, and texture‑sorted rendering.
+ * Requires entities to have a Component::ParticleEmitter; the
+ * std::vector<Component::Particle> holding its particles is created on
+ * demand. Handles spawning, physics, aging, and texture‑sorted rendering.
+ * Emitters are culled as a whole through a SpatialGrid of their particles'
+ * bounds before the particles of the visible ones are tested one by one.
  */
 class ParticleSystem : public System
 {
 public:
 
 	/**
-	 * @brief Constructs the system and registers component callbacks.
+	 * @brief Constructs the system, declares its access and registers component callbacks.
 	 */
 	ParticleSystem();
 
@@ -34,17 +37,34 @@ public:
 	 * - Removes expired particles.
 	 * - If emitter is playing, spawns particles at the given rate.
 	 * - Marks sort dirty when particles change.
+	 *
+	 * Particles and emitters are modified in place; the particle vector is
+	 * marked changed only when particles were added or removed. Emitters without
+	 * a particle vector get one through the registry command buffer.
 	 */
 	void Update(const float deltaT) override;
 
 	/**
 	 * @brief Renders all visible particles.
 	 *
-	 * Interpolates color and size based on age/lifetime.
+	 * Interpolates color and size based on age/lifetime. Positions and rotations
+	 * are moved back along the velocities to match the engine interpolation alpha.
 	 * Uses DrawTexturePro if a valid texture is provided, otherwise falls back to circles.
+	 * Does nothing on frames drawn from a snapshot (Engine::IsDrawingSnapshot); Extract is used instead.
 	 */
 	void Draw() const override;
 
+	/**
+	 * @brief Copies all visible particles into a render snapshot.
+	 * @param snapshot Snapshot to append to.
+	 */
+	void Extract(RenderSnapshot& snapshot) const override;
+
+	/**
+	 * @brief Returns true if no particle is alive and no emitter is spawning.
+	 */
+	bool IsIdle() const override;
+
 	/**
 	 * @brief Instantly spawns a burst of particles.
 	 * @param entity Entity holding the ParticleEmitter.
@@ -71,7 +91,18 @@ private:
 	static void SpawnParticle(const Entity entity, const Component::ParticleEmitter& emitter,
 	const Vec2<float>& worldPos);
 
+	static Component::Particle CreateParticle(const Component::ParticleEmitter& emitter, const Vec2<float>& worldPos);
+
+	// Stores the area the emitter's particles can be drawn in, for culling
+	void UpdateBounds(const Entity entity, const std::vector<Component::Particle>& particles);
+
 	void MarkNeedSort();
 
 	bool m_needSort = false;
+
+	// Particle bounds of every emitter with live particles
+	SpatialGrid m_grid;
+
+	// Grid query results, kept between frames to reuse the memory
+	mutable std::vector<Entity> m_visibleEmitters;
 };
\ No newline at end of file
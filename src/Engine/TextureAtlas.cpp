@@ -0,0 +1,231 @@
+#include "TextureAtlas.hpp"
+
+#include "Assert.hpp"
+#include "Engine/Engine.hpp"
+#include "Log/Logger.hpp"
+
+#define STB_RECT_PACK_IMPLEMENTATION
+#define STBRP_STATIC
+#include "rlImGui/imstb_rectpack.h"
+
+struct TextureAtlas::Page
+{
+	stbrp_context context;
+	std::vector<stbrp_node> nodes;
+
+	std::shared_ptr<Texture2D> texture;
+};
+
+Rectangle TextureAtlas::Region::Sub(const Rectangle& rectangle) const
+{
+	return {this->rectangle.x + rectangle.x, this->rectangle.y + rectangle.y, rectangle.width, rectangle.height};
+}
+
+TextureAtlas::TextureAtlas(const u32 pageSize, const u32 padding) :
+m_pageSize(pageSize),
+m_padding(padding),
+m_id(s_nextAtlas++)
+{
+	Assert(pageSize, "Atlas pages must not be empty");
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::Add(const std::string& path)
+{
+	if (std::optional<Region> region = Get(path))
+	{
+		return region;
+	}
+
+	std::shared_ptr<Image> image = RESOURCE_MANAGER.GetCache<Image>()->Get(path);
+	if (!image)
+	{
+		image = RESOURCE_MANAGER.GetCache<Image>()->Load(path);
+	}
+
+	if (!image)
+	{
+		Logger::Write<LogLevel::WARN>("Failed to load atlas image ", path);
+		return std::nullopt;
+	}
+
+	std::vector<Pending> pending = {{path, image}};
+	Pack(pending);
+
+	return Get(path);
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::Add(const std::string& name, const Image& image)
+{
+	if (std::optional<Region> region = Get(name))
+	{
+		return region;
+	}
+
+	// Borrowed, the caller keeps ownership
+	std::shared_ptr<Image> borrowed(std::shared_ptr<Image>(), const_cast<Image*>(&image));
+
+	std::vector<Pending> pending = {{name, borrowed}};
+	Pack(pending);
+
+	return Get(name);
+}
+
+bool TextureAtlas::Add(std::span<const std::string> paths)
+{
+	std::vector<Pending> pending;
+	bool allLoaded = true;
+
+	for (const std::string& path : paths)
+	{
+		if (m_regions.contains(path))
+		{
+			continue;
+		}
+
+		std::shared_ptr<Image> image = RESOURCE_MANAGER.GetCache<Image>()->Get(path);
+		if (!image)
+		{
+			image = RESOURCE_MANAGER.GetCache<Image>()->Load(path);
+		}
+
+		if (!image)
+		{
+			Logger::Write<LogLevel::WARN>("Failed to load atlas image ", path);
+			allLoaded = false;
+
+			continue;
+		}
+
+		pending.push_back({path, image});
+	}
+
+	return Pack(pending) && allLoaded;
+}
+
+std::optional<TextureAtlas::Region> TextureAtlas::Get(const std::string& name) const
+{
+	auto it = m_regions.find(name);
+	if (it == m_regions.end())
+	{
+		return std::nullopt;
+	}
+
+	return it->second;
+}
+
+u32 TextureAtlas::GetPageCount() const
+{
+	return m_pages.size();
+}
+
+bool TextureAtlas::Pack(std::vector<Pending>& pending)
+{
+	std::vector<stbrp_rect> rects;
+	rects.reserve(pending.size());
+
+	bool allFit = true;
+
+	for (u64 i = 0; i < pending.size(); i++)
+	{
+		const Image& image = *pending[i].image;
+
+		const u32 width = image.width + m_padding;
+		const u32 height = image.height + m_padding;
+
+		if (width > m_pageSize || height > m_pageSize)
+		{
+			Logger::Write<LogLevel::WARN>("Image ", pending[i].name, " is too large for the atlas");
+			allFit = false;
+
+			continue;
+		}
+
+		rects.push_back({.id = static_cast<i32>(i), .w = static_cast<i32>(width), .h = static_cast<i32>(height)});
+	}
+
+	// Fill the free space of existing pages first, then open new ones for the rest
+	u64 page = 0;
+	while (!rects.empty())
+	{
+		const bool newPage = page == m_pages.size();
+		Page& target = newPage ? AddPage() : *m_pages[page];
+
+		stbrp_pack_rects(&target.context, rects.data(), rects.size());
+
+		for (const stbrp_rect& rect : rects)
+		{
+			if (!rect.was_packed)
+			{
+				continue;
+			}
+
+			const Pending& entry = pending[rect.id];
+
+			// Padding sits on the top left of every packed rectangle, separating it from its neighbours
+			const Rectangle rectangle = {static_cast<float>(rect.x + m_padding),
+			static_cast<float>(rect.y + m_padding), static_cast<float>(entry.image->width),
+			static_cast<float>(entry.image->height)};
+
+			Upload(target, *entry.image, rectangle);
+
+			m_regions[entry.name] = {*target.texture, rectangle};
+		}
+
+		std::erase_if(rects, [](const stbrp_rect& rect)
+		{
+			return rect.was_packed;
+		});
+
+		page++;
+	}
+
+	return allFit;
+}
+
+TextureAtlas::Page& TextureAtlas::AddPage()
+{
+	auto page = std::make_unique<Page>();
+
+	// One node per pixel of width gives the best packing
+	page->nodes.resize(m_pageSize);
+	stbrp_init_target(&page->context, m_pageSize, m_pageSize, page->nodes.data(), page->nodes.size());
+
+	Texture2D texture;
+
+	if (Engine::Get().IsHeadless())
+	{
+		texture = {.id = 1, .width = static_cast<i32>(m_pageSize), .height = static_cast<i32>(m_pageSize),
+		.mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+	}
+
+	else
+	{
+		Image blank = GenImageColor(m_pageSize, m_pageSize, BLANK);
+		texture = LoadTextureFromImage(blank);
+		UnloadImage(blank);
+
+		SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+	}
+
+	const std::string name = "TextureAtlas" + std::to_string(m_id) + "/" + std::to_string(m_pages.size());
+	page->texture = RESOURCE_MANAGER.GetCache<Texture2D>()->Add(std::move(texture), name);
+
+	m_pages.push_back(std::move(page));
+
+	return *m_pages.back();
+}
+
+void TextureAtlas::Upload(const Page& page, const Image& image, const Rectangle& rectangle)
+{
+	if (Engine::Get().IsHeadless())
+	{
+		return;
+	}
+
+	Image copy = ImageCopy(image);
+	ImageFormat(&copy, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+	UpdateTextureRec(*page.texture, rectangle, copy.data);
+
+	UnloadImage(copy);
+}
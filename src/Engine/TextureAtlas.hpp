@@ -0,0 +1,143 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include "raylib.h"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file TextureAtlas.hpp
+ * @brief Runtime texture atlas packing.
+ */
+
+/**
+ * @brief Packs many small images into a few large textures
+ *
+ * Sprites sharing a texture are drawn in a single batch, so packing the images of
+ * many sprites into atlas pages lets thousands of distinct sprites be drawn in a
+ * handful of draw calls.
+ *
+ * Images are copied into pages of pageSize by pageSize pixels, opening a new page
+ * when the current ones are full. Adding images later packs them into the free
+ * space left on existing pages, so regions handed out earlier never move. Pages
+ * are stored in the Texture2D cache and stay alive while the atlas or the cache
+ * holds them.
+ *
+ * Usage:
+ * @code
+ * TextureAtlas atlas;
+ * atlas.Add(std::vector<std::string>{"assets/tree.png", "assets/rock.png"});
+ *
+ * const TextureAtlas::Region tree = *atlas.Get("assets/tree.png");
+ * REGISTRY.Emplace<Component::Sprite>(entity, Component::Sprite{.texture = tree.texture, .rectangle = tree.rectangle});
+ * @endcode
+ */
+class TextureAtlas : public NonCopyable<>
+{
+public:
+
+	/**
+	 * @brief Where an image ended up in the atlas
+	 */
+	struct Region
+	{
+		Texture2D texture = {};
+		Rectangle rectangle = {};
+
+		/**
+		 * @brief Maps a rectangle within the original image into the atlas
+		 *
+		 * Used for sprite sheets, such as Component::Animation frames.
+		 *
+		 * @param rectangle Rectangle in the original image's pixels
+		 * @return The same rectangle in the atlas page's pixels
+		 */
+		Rectangle Sub(const Rectangle& rectangle) const;
+	};
+
+	/**
+	 * @brief Creates an empty atlas
+	 *
+	 * @param pageSize Width and height of every page in pixels
+	 * @param padding  Transparent pixels left around every image to avoid bleeding when filtered
+	 */
+	explicit TextureAtlas(const u32 pageSize = 2048, const u32 padding = 2);
+
+	/**
+	 * @brief Packs an image loaded through the Image cache
+	 *
+	 * Returns the existing region if the path was already added.
+	 *
+	 * @param path Image file path, also the name it is stored under
+	 * @return The region, or nullopt if the image failed to load or is larger than a page
+	 */
+	std::optional<Region> Add(const std::string& path);
+
+	/**
+	 * @brief Packs an image under a name
+	 *
+	 * Returns the existing region if the name was already added.
+	 *
+	 * @param name  Name to store the region under
+	 * @param image Image to copy into the atlas
+	 * @return The region, or nullopt if the image is larger than a page
+	 */
+	std::optional<Region> Add(const std::string& name, const Image& image);
+
+	/**
+	 * @brief Packs several images loaded through the Image cache at once
+	 *
+	 * Packing many images together fits them tighter than adding them one by one.
+	 *
+	 * @param paths Image file paths
+	 * @return True if every image was packed
+	 */
+	bool Add(std::span<const std::string> paths);
+
+	/**
+	 * @brief Returns the region of a previously added image
+	 *
+	 * @param name Path or name the image was added under
+	 * @return The region, or nullopt if not in the atlas
+	 */
+	std::optional<Region> Get(const std::string& name) const;
+
+	/**
+	 * @brief Returns the number of atlas pages
+	 */
+	u32 GetPageCount() const;
+
+private:
+
+	struct Page;
+
+	struct Pending
+	{
+		std::string name;
+		std::shared_ptr<Image> image;
+	};
+
+	// Packs images into free space, opening pages as needed; returns false if any did not fit
+	bool Pack(std::vector<Pending>& pending);
+
+	Page& AddPage();
+
+	void Upload(const Page& page, const Image& image, const Rectangle& rectangle);
+
+	u32 m_pageSize;
+	u32 m_padding;
+
+	std::vector<std::unique_ptr<Page>> m_pages;
+
+	std::unordered_map<std::string, Region> m_regions;
+
+	static inline u32 s_nextAtlas = 0;
+	u32 m_id;
+};
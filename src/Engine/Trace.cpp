@@ -0,0 +1,164 @@
+#include "Trace.hpp"
+
+#include "Log/Logger.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+bool Trace::Capture([[maybe_unused]] const u32 frames, [[maybe_unused]] const std::string& path)
+{
+#ifndef ENGINE_TRACING
+	Logger::Write<LogLevel::WARN>("Tracing is compiled out, define ENGINE_TRACING to capture");
+
+	return false;
+#else
+	std::unique_lock lock(s_captureMutex);
+
+	if (!frames || s_pending || s_active.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	s_pending = true;
+	s_frames = frames;
+	s_path = path;
+
+	return true;
+#endif
+}
+
+bool Trace::IsCapturing()
+{
+	std::unique_lock lock(s_captureMutex);
+
+	return s_pending || s_active.load(std::memory_order_relaxed);
+}
+
+void Trace::EndFrame()
+{
+	std::unique_lock lock(s_captureMutex);
+
+	if (s_pending)
+	{
+		s_pending = false;
+		s_framesLeft = s_frames;
+		s_captureStart = Now();
+
+		s_active.store(true, std::memory_order_relaxed);
+
+		return;
+	}
+
+	if (!s_active.load(std::memory_order_relaxed) || --s_framesLeft)
+	{
+		return;
+	}
+
+	s_active.store(false, std::memory_order_relaxed);
+
+	if (!Write())
+	{
+		Logger::Write<LogLevel::ERROR>("Failed to write trace to ", s_path);
+	}
+}
+
+const char* Trace::Intern(const std::string_view name)
+{
+	std::unique_lock lock(s_namesMutex);
+
+	// Set nodes don't move, so the pointer stays valid as more names are added
+	return s_names.emplace(name).first->c_str();
+}
+
+void Trace::Record(const char* name, const u64 start, const u64 end)
+{
+	if (!t_buffer)
+	{
+		std::unique_lock lock(s_buffersMutex);
+
+		s_buffers.push_back(std::make_unique<Buffer>());
+
+		t_buffer = s_buffers.back().get();
+		t_buffer->thread = s_buffers.size() - 1;
+	}
+
+	const u64 head = t_buffer->head.load(std::memory_order_relaxed);
+
+	t_buffer->events[head % BUFFER_CAPACITY] = {name, start, end};
+
+	t_buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Trace::Write()
+{
+	std::ofstream file(s_path);
+	if (!file)
+	{
+		return false;
+	}
+
+	auto writeEscaped = [&file](const char* string)
+	{
+		for (; *string; string++)
+		{
+			if (*string == '"' || *string == '\\')
+			{
+				file << '\\';
+			}
+
+			file << *string;
+		}
+	};
+
+	// Microseconds with nanosecond precision
+	file << std::fixed << std::setprecision(3);
+
+	file << "{\"traceEvents\":[";
+
+	bool first = true;
+
+	std::unique_lock lock(s_buffersMutex);
+
+	for (const std::unique_ptr<Buffer>& buffer : s_buffers)
+	{
+		const u64 head = buffer->head.load(std::memory_order_acquire);
+		const u64 begin = head - std::min<u64>(head, BUFFER_CAPACITY);
+
+		bool named = false;
+
+		for (u64 i = begin; i < head; i++)
+		{
+			const Event& event = buffer->events[i % BUFFER_CAPACITY];
+			if (event.start < s_captureStart)
+			{
+				continue;
+			}
+
+			if (!first)
+			{
+				file << ',';
+			}
+
+			first = false;
+
+			if (!named)
+			{
+				file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread
+					 << ",\"args\":{\"name\":\"Thread " << buffer->thread << "\"}},";
+
+				named = true;
+			}
+
+			file << "{\"name\":\"";
+			writeEscaped(event.name);
+			file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread
+				 << ",\"ts\":" << (event.start - s_captureStart) / 1000.0
+				 << ",\"dur\":" << (event.end - event.start) / 1000.0 << '}';
+		}
+	}
+
+	file << "]}";
+
+	return static_cast<bool>(file);
+}
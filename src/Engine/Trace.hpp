@@ -0,0 +1,178 @@
+#pragma once
+
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @file Trace.hpp
+ * @brief Scoped timeline tracing with Chrome trace export.
+ */
+
+#ifdef ENGINE_TRACING
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// Records the enclosing scope while a capture is running; name must be a literal or from Trace::Intern
+#define TRACE_SCOPE(name) const Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+/// Marks a frame boundary, starting and finishing requested captures
+#define TRACE_FRAME() Trace::EndFrame()
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_FRAME() ((void)0)
+#endif
+
+/**
+ * @brief Records a timeline of named scopes across threads
+ *
+ * Each thread writes begin and end timestamps in nanoseconds into its own ring
+ * buffer, so recording takes no locks. While no capture is running a scope only
+ * checks a flag. Capture records a number of frames and writes them to a Chrome
+ * trace JSON file, which can be opened in chrome://tracing or Perfetto.
+ *
+ * Scopes are placed with the TRACE_SCOPE macro which, along with TRACE_FRAME, is
+ * compiled out unless ENGINE_TRACING is defined.
+ *
+ * Usage:
+ * @code
+ * void MySystem::Update(const float deltaT)
+ * {
+ *     TRACE_SCOPE("MySystem::Update");
+ *     ...
+ * }
+ *
+ * Trace::Capture(120, "trace.json");
+ * @endcode
+ */
+class Trace
+{
+public:
+
+	/**
+	 * @brief Records the time between its construction and destruction
+	 *
+	 * Does nothing if no capture was running when it was constructed.
+	 */
+	class Scope : public NonCopyable<>
+	{
+	public:
+
+		explicit Scope(const char* name) :
+		m_name(s_active.load(std::memory_order_relaxed) ? name : nullptr)
+		{
+			if (m_name)
+			{
+				m_start = Now();
+			}
+		}
+
+		~Scope()
+		{
+			if (m_name)
+			{
+				Record(m_name, m_start, Now());
+			}
+		}
+
+	private:
+
+		const char* m_name;
+		u64 m_start = 0;
+	};
+
+	/**
+	 * @brief Captures the next frames and writes them as a Chrome trace file
+	 *
+	 * The capture starts at the next frame boundary and the file is written at the
+	 * frame boundary after the last captured frame. Only the latest events per thread
+	 * that fit in its ring buffer are kept.
+	 *
+	 * @param frames Number of frames to capture
+	 * @param path   File to write the trace to
+	 * @return False if a capture is already pending or running, or tracing is compiled out
+	 */
+	static bool Capture(const u32 frames, const std::string& path);
+
+	/**
+	 * @brief Returns true if a capture is pending or running
+	 */
+	static bool IsCapturing();
+
+	/**
+	 * @brief Marks a frame boundary
+	 *
+	 * Called once per frame by the Engine run loops through TRACE_FRAME.
+	 */
+	static void EndFrame();
+
+	/**
+	 * @brief Returns a copy of a name that lives until the program exits
+	 *
+	 * Events keep only a pointer to their name and are written after the capture,
+	 * so names built at runtime, such as system names or script paths, must be
+	 * interned rather than passed from a string that may be destroyed meanwhile.
+	 * Interning the same name again returns the same pointer. Takes a lock, so
+	 * intern once and keep the pointer instead of interning in every scope.
+	 *
+	 * @param name Name to copy
+	 * @return Pointer to the interned name
+	 */
+	static const char* Intern(const std::string_view name);
+
+private:
+
+	struct Event
+	{
+		const char* name;
+		u64 start;
+		u64 end;
+	};
+
+	static constexpr u32 BUFFER_CAPACITY = 1 << 15;
+
+	struct Buffer
+	{
+		std::array<Event, BUFFER_CAPACITY> events;
+		std::atomic<u64> head = 0;
+		u32 thread = 0;
+	};
+
+	static u64 Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+	}
+
+	static void Record(const char* name, const u64 start, const u64 end);
+
+	static bool Write();
+
+	static inline std::atomic<bool> s_active = false;
+
+	// Buffers outlive their threads so their events can still be written
+	static inline std::mutex s_buffersMutex;
+	static inline std::vector<std::unique_ptr<Buffer>> s_buffers;
+	static inline thread_local Buffer* t_buffer = nullptr;
+
+	// Never shrinks, events may point into it long after a name stops being used
+	static inline std::mutex s_namesMutex;
+	static inline std::unordered_set<std::string> s_names;
+
+	static inline std::mutex s_captureMutex;
+	static inline bool s_pending = false;
+	static inline u32 s_frames = 0;
+	static inline u32 s_framesLeft = 0;
+	static inline u64 s_captureStart = 0;
+	static inline std::string s_path;
+};